@@ -9,8 +9,13 @@
 #ifndef LLVM_DEMANGLE_DEMANGLE_H
 #define LLVM_DEMANGLE_DEMANGLE_H
 
+#include <demangler/DemangleConfig.h>
+
 #include <cstddef>
 #include <string>
+#if DEMANGLE_HAS_STRING_VIEW
+#include <string_view>
+#endif
 
 namespace llvm
 {
@@ -28,10 +33,35 @@ namespace llvm
         demangle_invalid_mangled_name = -2,
         demangle_memory_alloc_failure = -1,
         demangle_success = 0,
+        demangle_truncated = 1,
     };
 
+    // Each function below that takes a NUL-terminated MangledName also comes
+    // in a version that takes Length, the size of MangledName, which then
+    // needn't be terminated and is parsed in place. With C++17 they take a
+    // std::string_view too.
+
     char *itaniumDemangle(const char *mangled_name, char *buf, size_t *n,
         int *status);
+    char *itaniumDemangle(const char *MangledName, size_t Length, char *Buf,
+        size_t *N, int *Status);
+
+    /// Demangles an Itanium type rather than a symbol, such as the
+    /// "St6vectorIiSaIiEE" that typeid(T).name() returns, into
+    /// "std::vector<int, std::allocator<int>>". MangledName needn't be
+    /// NUL-terminated. Buf, N and Status behave like for itaniumDemangle.
+    char *itaniumDemangleTypeName(const char *MangledName, size_t Length,
+        char *Buf, size_t *N, int *Status);
+
+#if DEMANGLE_HAS_ATOMIC
+    /// Like itaniumDemangleTypeName, but caches the results for the whole
+    /// process, keyed by the address of the NUL-terminated MangledName rather
+    /// than its contents. So it's meant for names that don't move or change,
+    /// like those of type_info objects. Threads look results up and add them
+    /// without taking locks. The result stays valid until the process exits;
+    /// nullptr means the name couldn't be demangled.
+    const char *itaniumDemangleTypeNameCached(const char *MangledName);
+#endif
 
     enum MSDemangleFlags
     {
@@ -58,12 +88,74 @@ namespace llvm
     char *microsoftDemangle(const char *mangled_name, size_t *n_read, char *buf,
         size_t *n_buf, int *status,
         MSDemangleFlags Flags = MSDF_None);
+    char *microsoftDemangle(const char *MangledName, size_t Length,
+        size_t *NRead, char *Buf, size_t *NBuf, int *Status,
+        MSDemangleFlags Flags = MSDF_None);
+
+    /// Demangles an MSVC RTTI type name, as returned by type_info::raw_name(),
+    /// such as ".?AVFoo@ns@@" into "class ns::Foo". MangledName needn't be
+    /// NUL-terminated. buf, n_buf and status behave like for microsoftDemangle.
+    char *microsoftDemangleTypeName(const char *MangledName, size_t Length,
+        char *buf, size_t *n_buf, int *status);
+
+#if DEMANGLE_HAS_THREAD_LOCAL
+    /// Like microsoftDemangleTypeName, but caches the results per thread, keyed
+    /// by the address and length of MangledName rather than its contents. So
+    /// it's meant for names that don't move or change, like those in RTTI data.
+    /// The result stays valid until the thread exits; nullptr means the name
+    /// couldn't be demangled.
+    const char *microsoftDemangleTypeNameCached(const char *MangledName,
+        size_t Length);
+#endif
+
+    class MSDemangleContext;
+
+    /// Like the above, but reuses the memory in Context rather than setting up
+    /// and tearing down a demangler for every symbol. Pass the same Context
+    /// when demangling many symbols in a row.
+    char *microsoftDemangle(const char *mangled_name, size_t *n_read, char *buf,
+        size_t *n_buf, int *status, MSDemangleContext &Context,
+        MSDemangleFlags Flags = MSDF_None);
+    char *microsoftDemangle(const char *MangledName, size_t Length,
+        size_t *NRead, char *Buf, size_t *NBuf, int *Status,
+        MSDemangleContext &Context, MSDemangleFlags Flags = MSDF_None);
+
+    /// The state microsoftDemangle keeps between symbols. A context must not be
+    /// used by more than one thread at a time.
+    class MSDemangleContext
+    {
+    public:
+        MSDemangleContext();
+        ~MSDemangleContext();
 
-    // Demangles a Rust v0 mangled symbol.
-    char *rustDemangle(const char *MangledName);
+        MSDemangleContext(const MSDemangleContext &) = delete;
+        MSDemangleContext &operator=(const MSDemangleContext &) = delete;
+
+    private:
+        friend char *microsoftDemangle(const char *, size_t, size_t *, char *,
+            size_t *, int *, MSDemangleContext &, MSDemangleFlags);
+
+        void *Context;
+    };
+
+    enum RustDemangleFlags
+    {
+        RDF_None = 0,
+        /// Leave out the hash of legacy symbols, the "::h0123456789abcdef"
+        /// at the end.
+        RDF_NoHash = 1 << 0,
+    };
+
+    // Demangles a Rust symbol, either v0 ("_R...") or legacy
+    // ("_ZN...17h<hash>E"). Legacy symbols are recognized by their hash.
+    char *rustDemangle(const char *MangledName,
+        RustDemangleFlags Flags = RDF_None);
+    char *rustDemangle(const char *MangledName, size_t Length,
+        RustDemangleFlags Flags = RDF_None);
 
     // Demangles a D mangled symbol.
     char *dlangDemangle(const char *MangledName);
+    char *dlangDemangle(const char *MangledName, size_t Length);
 
     /// Attempt to demangle a string using different demangling schemes.
     /// The function uses heuristics to determine which demangling scheme to use.
@@ -72,7 +164,274 @@ namespace llvm
     /// demangling occurred.
     std::string demangle(const std::string &MangledName);
 
+    /// The mangling schemes demangle() knows.
+    enum class DemangleScheme
+    {
+        Unknown,
+        Itanium, // Legacy Rust symbols are Itanium names too.
+        Rust,
+        DLang,
+        Microsoft,
+    };
+
+    enum DemangleFlags
+    {
+        DF_None = 0,
+        /// Every symbol has an extra leading underscore, as on Mach-O. It's
+        /// dropped first, and names without one aren't taken as mangled.
+        DF_StripUnderscore = 1 << 0,
+        /// Never take a name for a Microsoft symbol, for targets that have
+        /// none.
+        DF_NoMicrosoft = 1 << 1,
+    };
+
+    /// Tells which scheme demangle() would try on MangledName, from its first
+    /// few bytes alone. Unknown if it doesn't look mangled at all.
+    DemangleScheme classify(const char *MangledName,
+        DemangleFlags Flags = DF_None);
+    DemangleScheme classify(const char *MangledName, size_t Length,
+        DemangleFlags Flags = DF_None);
+
+    /// The result of demangle(const char *, size_t). Names shorter than
+    /// InlineSize are stored inline, so that demangling them doesn't allocate
+    /// at all; longer ones are kept in a malloc()ed buffer.
+    class DemangledName
+    {
+    public:
+        static constexpr size_t InlineSize = 256;
+
+        DemangledName()
+        {
+            Inline[0] = '\0';
+        }
+        DemangledName(const DemangledName &Other);
+        DemangledName(DemangledName &&Other);
+        DemangledName &operator=(DemangledName Other);
+        ~DemangledName();
+
+        /// The null-terminated name.
+        const char *c_str() const
+        {
+            return Heap ? Heap : Inline;
+        }
+        size_t size() const
+        {
+            return Size;
+        }
+        bool empty() const
+        {
+            return Size == 0;
+        }
+
+        std::string str() const
+        {
+            return std::string(c_str(), Size);
+        }
+        operator std::string() const
+        {
+            return str();
+        }
+
+    private:
+        friend DemangledName demangle(const char *MangledName, size_t Length);
+        friend DemangledName demangle(const char *MangledName, size_t Length,
+            DemangleScheme Scheme, DemangleFlags Flags);
+
+        char *Heap = nullptr;
+        size_t Size = 0;
+        char Inline[InlineSize];
+    };
+
+    /// Like demangle() above, but returns a DemangledName, which avoids the heap
+    /// entirely for names that fit inline. There is no overload taking just a
+    /// const char * or std::string_view, which would take over calls that have
+    /// always returned a std::string.
+    DemangledName demangle(const char *MangledName, size_t Length);
+
+    /// Like the above, but only tries Scheme's demangler, such as for the
+    /// scheme classify() returned, rather than each scheme in turn. The name
+    /// is left as it is if Scheme is Unknown.
+    DemangledName demangle(const char *MangledName, DemangleScheme Scheme,
+        DemangleFlags Flags = DF_None);
+    DemangledName demangle(const char *MangledName, size_t Length,
+        DemangleScheme Scheme, DemangleFlags Flags = DF_None);
+
+    /// classify() for Count names at once, Names[I] being Lengths[I] bytes
+    /// long, into Schemes[I]. The prefixes are compared a word at a time in a
+    /// loop without branches, which compilers can vectorize.
+    void classifyBatch(const char *const *Names, const size_t *Lengths,
+        size_t Count, DemangleScheme *Schemes, DemangleFlags Flags = DF_None);
+
+    /// Demangles Count names into Results[I], as demangle(Names[I],
+    /// Lengths[I], classify(Names[I], Lengths[I], Flags), Flags) would. The
+    /// names are classified up front and those of each scheme demangled in a
+    /// row, so that the demanglers don't take turns on a mixed batch.
+    void demangleBatch(const char *const *Names, const size_t *Lengths,
+        size_t Count, DemangledName *Results, DemangleFlags Flags = DF_None);
+
+    /// Appends the demangled MangledName to Out, or MangledName itself if no
+    /// scheme applies, picking the scheme like demangle() does. The name is
+    /// printed straight into Out, so appending many names to one string
+    /// costs no allocations beyond growing it.
+    /// \returns true if MangledName was demangled.
+    bool demangleAppend(const char *MangledName, std::string &Out);
+    bool demangleAppend(const char *MangledName, size_t Length,
+        std::string &Out);
+
+    /// Splits off the suffixes compilers add to the symbols of the clones
+    /// they make of functions, such as ".cold", ".part.0", ".isra.0",
+    /// ".constprop.1", ".llvm.1234567" or ".lto_priv.0", going by the
+    /// characters of MangledName alone. Returns the length of the symbol
+    /// without them, which is Length if it has none.
+    ///
+    /// A clone demangles to the demangled symbol followed by its suffixes, as
+    /// appendCloneSuffixes() prints them. So a cache of demangled names can
+    /// keep one entry for the symbol and all of its clones.
+    size_t splitCloneSuffixes(const char *MangledName, size_t Length);
+
+    /// The length of the first of the clone suffixes at Suffixes, as split
+    /// off by splitCloneSuffixes(): 7 for ".part.0.cold". 0 if Length is.
+    size_t nextCloneSuffix(const char *Suffixes, size_t Length);
+
+    /// Appends the clone suffixes split off by splitCloneSuffixes() to Out,
+    /// the way demangle() prints them after the demangled symbol.
+    void appendCloneSuffixes(const char *Suffixes, size_t Length,
+        std::string &Out);
+
     bool nonMicrosoftDemangle(const char *MangledName, std::string &Result);
+    bool nonMicrosoftDemangle(const char *MangledName, size_t Length,
+        std::string &Result);
+
+    /// Heap-free demangling, for places where malloc() can't be called, such
+    /// as signal handlers.
+    ///
+    /// These demangle MangledName into Buf, which is BufSize bytes large and
+    /// always receives a null-terminated string. Working memory is carved out
+    /// of the ScratchSize bytes at Scratch (a few kilobytes is plenty for
+    /// typical symbols; the Rust and D demanglers don't need any). Nothing is
+    /// allocated or freed and nothing is kept after the call returns. The Rust
+    /// demangler decodes Punycode identifiers of more than 256 code points in
+    /// the unused end of Buf, which needs 12 bytes per code point, and fails
+    /// with demangle_memory_alloc_failure if there isn't that much.
+    ///
+    /// The result is one of the demangle_ enum entries above:
+    /// demangle_success if Buf holds the whole demangled name,
+    /// demangle_truncated if it only holds as much of it as fit,
+    /// demangle_memory_alloc_failure if Scratch was too small, or
+    /// demangle_invalid_mangled_name / demangle_invalid_args. Buf is left empty
+    /// in the last three cases.
+    int itaniumDemangleNoHeap(const char *MangledName, char *Buf, size_t BufSize,
+        void *Scratch, size_t ScratchSize);
+    int itaniumDemangleNoHeap(const char *MangledName, size_t Length, char *Buf,
+        size_t BufSize, void *Scratch, size_t ScratchSize);
+    int microsoftDemangleNoHeap(const char *MangledName, char *Buf,
+        size_t BufSize, void *Scratch, size_t ScratchSize,
+        MSDemangleFlags Flags = MSDF_None);
+    int microsoftDemangleNoHeap(const char *MangledName, size_t Length,
+        char *Buf, size_t BufSize, void *Scratch, size_t ScratchSize,
+        MSDemangleFlags Flags = MSDF_None);
+    int rustDemangleNoHeap(const char *MangledName, char *Buf, size_t BufSize,
+        RustDemangleFlags Flags = RDF_None);
+    int rustDemangleNoHeap(const char *MangledName, size_t Length, char *Buf,
+        size_t BufSize, RustDemangleFlags Flags = RDF_None);
+    int dlangDemangleNoHeap(const char *MangledName, char *Buf, size_t BufSize);
+    int dlangDemangleNoHeap(const char *MangledName, size_t Length, char *Buf,
+        size_t BufSize);
+
+    /// Heap-free version of demangle(), see above. The scheme is picked the
+    /// same way, and if none applies Buf receives a copy of MangledName
+    /// (truncated if need be) and demangle_invalid_mangled_name is returned.
+    int demangleNoHeap(const char *MangledName, char *Buf, size_t BufSize,
+        void *Scratch, size_t ScratchSize);
+    int demangleNoHeap(const char *MangledName, size_t Length, char *Buf,
+        size_t BufSize, void *Scratch, size_t ScratchSize);
+
+#if DEMANGLE_HAS_STRING_VIEW
+    inline char *itaniumDemangle(std::string_view MangledName, char *Buf,
+        size_t *N, int *Status)
+    {
+        return itaniumDemangle(MangledName.data(), MangledName.size(), Buf, N,
+            Status);
+    }
+    inline char *microsoftDemangle(std::string_view MangledName, size_t *NRead,
+        char *Buf, size_t *NBuf, int *Status,
+        MSDemangleFlags Flags = MSDF_None)
+    {
+        return microsoftDemangle(MangledName.data(), MangledName.size(), NRead,
+            Buf, NBuf, Status, Flags);
+    }
+    inline char *microsoftDemangle(std::string_view MangledName, size_t *NRead,
+        char *Buf, size_t *NBuf, int *Status, MSDemangleContext &Context,
+        MSDemangleFlags Flags = MSDF_None)
+    {
+        return microsoftDemangle(MangledName.data(), MangledName.size(), NRead,
+            Buf, NBuf, Status, Context, Flags);
+    }
+    inline char *rustDemangle(std::string_view MangledName,
+        RustDemangleFlags Flags = RDF_None)
+    {
+        return rustDemangle(MangledName.data(), MangledName.size(), Flags);
+    }
+    inline char *dlangDemangle(std::string_view MangledName)
+    {
+        return dlangDemangle(MangledName.data(), MangledName.size());
+    }
+    inline DemangleScheme classify(std::string_view MangledName,
+        DemangleFlags Flags = DF_None)
+    {
+        return classify(MangledName.data(), MangledName.size(), Flags);
+    }
+    inline DemangledName demangle(std::string_view MangledName,
+        DemangleScheme Scheme, DemangleFlags Flags = DF_None)
+    {
+        return demangle(MangledName.data(), MangledName.size(), Scheme, Flags);
+    }
+    inline bool demangleAppend(std::string_view MangledName, std::string &Out)
+    {
+        return demangleAppend(MangledName.data(), MangledName.size(), Out);
+    }
+    inline size_t splitCloneSuffixes(std::string_view MangledName)
+    {
+        return splitCloneSuffixes(MangledName.data(), MangledName.size());
+    }
+    inline bool nonMicrosoftDemangle(std::string_view MangledName,
+        std::string &Result)
+    {
+        return nonMicrosoftDemangle(MangledName.data(), MangledName.size(),
+            Result);
+    }
+    inline int itaniumDemangleNoHeap(std::string_view MangledName, char *Buf,
+        size_t BufSize, void *Scratch, size_t ScratchSize)
+    {
+        return itaniumDemangleNoHeap(MangledName.data(), MangledName.size(), Buf,
+            BufSize, Scratch, ScratchSize);
+    }
+    inline int microsoftDemangleNoHeap(std::string_view MangledName, char *Buf,
+        size_t BufSize, void *Scratch, size_t ScratchSize,
+        MSDemangleFlags Flags = MSDF_None)
+    {
+        return microsoftDemangleNoHeap(MangledName.data(), MangledName.size(),
+            Buf, BufSize, Scratch, ScratchSize, Flags);
+    }
+    inline int rustDemangleNoHeap(std::string_view MangledName, char *Buf,
+        size_t BufSize, RustDemangleFlags Flags = RDF_None)
+    {
+        return rustDemangleNoHeap(MangledName.data(), MangledName.size(), Buf,
+            BufSize, Flags);
+    }
+    inline int dlangDemangleNoHeap(std::string_view MangledName, char *Buf,
+        size_t BufSize)
+    {
+        return dlangDemangleNoHeap(MangledName.data(), MangledName.size(), Buf,
+            BufSize);
+    }
+    inline int demangleNoHeap(std::string_view MangledName, char *Buf,
+        size_t BufSize, void *Scratch, size_t ScratchSize)
+    {
+        return demangleNoHeap(MangledName.data(), MangledName.size(), Buf,
+            BufSize, Scratch, ScratchSize);
+    }
+#endif
 
     /// "Partial" demangler. This supports demangling a string into an AST
     /// (typically an intermediate stage in itaniumDemangle) and querying certain
@@ -88,6 +447,13 @@ namespace llvm
         /// implicitly operate on the AST this produces.
         /// \return true on error, false otherwise
         bool partialDemangle(const char *MangledName);
+        bool partialDemangle(const char *MangledName, size_t Length);
+#if DEMANGLE_HAS_STRING_VIEW
+        bool partialDemangle(std::string_view MangledName)
+        {
+            return partialDemangle(MangledName.data(), MangledName.size());
+        }
+#endif
 
         /// Just print the entire mangled name into Buf. Buf and N behave like the
         /// second and third parameters to itaniumDemangle.
@@ -125,11 +491,184 @@ namespace llvm
         /// generated by the implementation, such as vtables and typeinfo names.
         bool isSpecialName() const;
 
+        /// Keep up to Bytes of the memory used by partialDemangle for later
+        /// calls, and release the rest when the next call starts. This saves
+        /// reallocating it for every symbol when demangling many of them,
+        /// while memory beyond that, such as for a one-off huge symbol, is
+        /// still released. Until this is called, the parser's tables keep
+        /// whatever they have grown to and the AST's memory is released.
+        void setRetainedMemory(size_t Bytes);
+
+        /// Release the memory kept for later calls. The current AST stays valid.
+        void shrink();
+
         ~ItaniumPartialDemangler();
 
     private:
         void *RootNode;
         void *Context;
+        size_t RetainedMemory = 0;
+        bool LimitsRetainedMemory = false;
+    };
+
+    /// What a Microsoft symbol names, see MSPartialDemangler::getKind().
+    enum class MSSymbolKind
+    {
+        Function,
+        Variable,
+        Thunk, // A this-adjusting thunk.
+        VcallThunk,
+        Vftable,
+        Vbtable,
+        LocalVftable,
+        RttiTypeDescriptor,
+        RttiBaseClassDescriptor,
+        RttiBaseClassArray,
+        RttiClassHierarchyDescriptor,
+        RttiCompleteObjLocator,
+        StringLiteral,
+        LocalStaticGuard,
+        DynamicInitializer,
+        DynamicAtexitDestructor,
+        Md5, // A name too long to mangle, replaced by its MD5 hash.
+    };
+
+    /// The access specifier of a Microsoft class member.
+    enum class MSAccess
+    {
+        None,
+        Public,
+        Protected,
+        Private,
+    };
+
+    /// The Microsoft counterpart of ItaniumPartialDemangler: demangles a symbol
+    /// into an AST, then answers questions about it and prints parts of it on
+    /// demand. The AST refers to the mangled name, which must outlive it.
+    struct MSPartialDemangler
+    {
+        MSPartialDemangler();
+
+        MSPartialDemangler(MSPartialDemangler &&Other);
+        MSPartialDemangler &operator=(MSPartialDemangler &&Other);
+
+        /// Demangle into an AST. Subsequent calls to the rest of the member
+        /// functions implicitly operate on the AST this produces.
+        /// \return true on error, false otherwise
+        bool partialDemangle(const char *MangledName);
+        bool partialDemangle(const char *MangledName, size_t Length);
+#if DEMANGLE_HAS_STRING_VIEW
+        bool partialDemangle(std::string_view MangledName)
+        {
+            return partialDemangle(MangledName.data(), MangledName.size());
+        }
+#endif
+
+        /// Print the entire demangled name into Buf. Buf and N behave like the
+        /// third and fourth parameters to microsoftDemangle.
+        char *finishDemangle(char *Buf, size_t *N,
+            MSDemangleFlags Flags = MSDF_None) const;
+
+        /// Get the scope the symbol is in. For "a::b<int>::c" this returns
+        /// "a::b<int>". Empty for a global symbol.
+        char *getScope(char *Buf, size_t *N) const;
+
+        /// Get the unqualified name without its template arguments. For
+        /// "a::b::c<int>" this returns "c".
+        char *getBaseName(char *Buf, size_t *N) const;
+
+        /// Get the template arguments of the unqualified name, such as "<int>".
+        /// Empty if it has none.
+        char *getTemplateArgs(char *Buf, size_t *N) const;
+
+        /// Get the parameter list of a function, such as "(int, char)".
+        /// These return nullptr if the symbol isn't a function.
+        char *getFunctionParameters(char *Buf, size_t *N) const;
+        char *getFunctionReturnType(char *Buf, size_t *N) const;
+        char *getCallingConvention(char *Buf, size_t *N) const;
+
+        /// The access specifier of a class member, or MSAccess::None.
+        MSAccess getAccess() const;
+
+        /// What kind of entity the symbol names.
+        MSSymbolKind getKind() const;
+
+        /// If this symbol describes a function, including thunks.
+        bool isFunction() const;
+
+        ~MSPartialDemangler();
+
+    private:
+        void *RootNode;
+        void *Context;
+    };
+
+    /// The Rust v0 counterpart of ItaniumPartialDemangler. The symbol is
+    /// demangled in one pass that also notes where each part of its path ends
+    /// up, so the parts can be had without taking the demangled name apart.
+    /// Crate names refer to the mangled name, which must outlive them.
+    struct RustPartialDemangler
+    {
+        RustPartialDemangler();
+
+        RustPartialDemangler(RustPartialDemangler &&Other);
+        RustPartialDemangler &operator=(RustPartialDemangler &&Other);
+
+        /// Demangle MangledName. Subsequent calls to the rest of the member
+        /// functions implicitly operate on it.
+        /// \return true on error, false otherwise
+        bool partialDemangle(const char *MangledName);
+        bool partialDemangle(const char *MangledName, size_t Length);
+#if DEMANGLE_HAS_STRING_VIEW
+        bool partialDemangle(std::string_view MangledName)
+        {
+            return partialDemangle(MangledName.data(), MangledName.size());
+        }
+#endif
+
+        /// Print the entire demangled name into Buf. Buf and N behave like the
+        /// second and third parameters to itaniumDemangle.
+        char *finishDemangle(char *Buf, size_t *N) const;
+
+        /// Get the crate the symbol's path starts from: "alloc" for both
+        /// "alloc::vec::Vec<T>::new" and "<alloc::vec::Vec<T> as Clone>::clone",
+        /// wherever the impl is. If the self type isn't a path, the trait's
+        /// crate, "core" for "<[T] as core::fmt::Debug>::fmt", or for an
+        /// inherent impl such as "<[T]>::len", the crate of the impl.
+        char *getCrateName(char *Buf, size_t *N) const;
+
+        /// Get the crate the symbol was instantiated in. nullptr if the
+        /// mangled name doesn't say.
+        char *getInstantiatingCrate(char *Buf, size_t *N) const;
+
+        /// The "::"-separated parts of the symbol's path, without generic
+        /// arguments. For "<a::T as a::Tr>::f::{closure#0}" they are
+        /// "<a::T as a::Tr>", "f" and "{closure#0}".
+        size_t getNumPathSegments() const;
+        char *getPathSegment(size_t Index, char *Buf, size_t *N) const;
+
+        /// The namespace of a path segment: 'C' for closures, 'S' for shims,
+        /// other upper-case letters for other special namespaces, lower-case
+        /// ones for items (such as 't' for types and 'v' for values), and '\0'
+        /// for the first segment.
+        char getPathSegmentNamespace(size_t Index) const;
+
+        /// Get the T of a path in "<T>" or "<T as Trait>". nullptr if the path
+        /// doesn't start with one.
+        char *getImplSelfType(char *Buf, size_t *N) const;
+
+        /// Get the Trait of a path in "<T as Trait>". nullptr if the path
+        /// doesn't start with one.
+        char *getTraitName(char *Buf, size_t *N) const;
+
+        /// Get the outermost generic arguments of the path, such as "<u8>" for
+        /// "a::f::<u8>". Empty if it has none.
+        char *getGenericArgs(char *Buf, size_t *N) const;
+
+        ~RustPartialDemangler();
+
+    private:
+        void *Context;
     };
 } // namespace llvm
 
@@ -81,6 +81,23 @@
 #define DEMANGLE_FALLTHROUGH
 #endif
 
+// Define DEMANGLE_NO_THREAD_LOCAL where thread_local isn't supported, such as
+// in a kernel, to leave out the functions that keep per-thread caches.
+#ifndef DEMANGLE_NO_THREAD_LOCAL
+#define DEMANGLE_HAS_THREAD_LOCAL 1
+#endif
+
+// Likewise, define DEMANGLE_NO_ATOMIC where std::atomic isn't available to
+// leave out the functions that keep caches shared between threads.
+#ifndef DEMANGLE_NO_ATOMIC
+#define DEMANGLE_HAS_ATOMIC 1
+#endif
+
+// The std::string_view overloads in Demangle.h need C++17.
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define DEMANGLE_HAS_STRING_VIEW 1
+#endif
+
 #define DEMANGLE_NAMESPACE_BEGIN   \
     namespace llvm                 \
     {                              \
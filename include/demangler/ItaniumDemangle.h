@@ -42,6 +42,11 @@ class PODSmallVector
     T *Cap = nullptr;
     T Inline[N] = { 0 };
 
+    // When set, the vector grows into this region rather than the heap. If
+    // the region runs out, push_back() drops the element; the region stays
+    // exhausted, which tells the owner to discard whatever it was building.
+    ScratchRegion *Scratch = nullptr;
+
     bool isInline() const
     {
         return First == Inline;
@@ -54,10 +59,19 @@ class PODSmallVector
         Cap = Inline + N;
     }
 
-    void reserve(size_t NewCap)
+    bool reserve(size_t NewCap)
     {
         size_t S = size();
-        if (isInline())
+        if (Scratch != nullptr)
+        {
+            auto *Tmp = static_cast<T *>(
+                Scratch->allocate(NewCap * sizeof(T), alignof(T)));
+            if (Tmp == nullptr)
+                return false;
+            std::copy(First, Last, Tmp);
+            First = Tmp;
+        }
+        else if (isInline())
         {
             auto *Tmp = static_cast<T *>(std::malloc(NewCap * sizeof(T)));
             if (Tmp == nullptr)
@@ -73,6 +87,7 @@ class PODSmallVector
         }
         Last = First + S;
         Cap = First + NewCap;
+        return true;
     }
 
 public:
@@ -85,6 +100,7 @@ public:
     PODSmallVector(PODSmallVector &&Other) :
         PODSmallVector()
     {
+        Scratch = Other.Scratch;
         if (Other.isInline())
         {
             std::copy(Other.begin(), Other.end(), First);
@@ -105,9 +121,11 @@ public:
         {
             if (!isInline())
             {
-                std::free(First);
+                if (Scratch == nullptr)
+                    std::free(First);
                 clearInline();
             }
+            Scratch = Other.Scratch;
             std::copy(Other.begin(), Other.end(), First);
             Last = First + Other.size();
             Other.clear();
@@ -116,6 +134,7 @@ public:
 
         if (isInline())
         {
+            Scratch = Other.Scratch;
             First = Other.First;
             Last = Other.Last;
             Cap = Other.Cap;
@@ -123,6 +142,7 @@ public:
             return *this;
         }
 
+        std::swap(Scratch, Other.Scratch);
         std::swap(First, Other.First);
         std::swap(Last, Other.Last);
         std::swap(Cap, Other.Cap);
@@ -130,11 +150,18 @@ public:
         return *this;
     }
 
+    // Make the vector grow into Region from now on.
+    void useScratch(ScratchRegion &Region)
+    {
+        assert(isInline() && "Heap storage would be leaked!");
+        Scratch = &Region;
+    }
+
     // NOLINTNEXTLINE(readability-identifier-naming)
     void push_back(const T &Elem)
     {
-        if (Last == Cap)
-            reserve(size() * 2);
+        if (Last == Cap && !reserve(size() * 2))
+            return;
         *Last++ = Elem;
     }
 
@@ -183,9 +210,25 @@ public:
         Last = First;
     }
 
+    // The heap memory this vector holds on to, which clear() keeps for reuse.
+    size_t heapCapacity() const
+    {
+        if (isInline() || Scratch != nullptr)
+            return 0;
+        return static_cast<size_t>(Cap - First) * sizeof(T);
+    }
+
+    // Empty the vector and release its heap memory.
+    void shrinkToInline()
+    {
+        if (!isInline() && Scratch == nullptr)
+            std::free(First);
+        clearInline();
+    }
+
     ~PODSmallVector()
     {
-        if (!isInline())
+        if (!isInline() && Scratch == nullptr)
             std::free(First);
     }
 };
@@ -868,9 +911,13 @@ class ReferenceType : public Node
     std::pair<ReferenceKind, const Node *> collapse(OutputBuffer &OB) const
     {
         auto SoFar = std::make_pair(RK, Pointee);
-        // Track the chain of nodes for the Floyd's 'tortoise and hare'
-        // cycle-detection algorithm, since getSyntaxNode(S) is impure
-        PODSmallVector<const Node *, 8> Prev;
+        // Brent's cycle-detection algorithm: compare against a saved node that
+        // is moved forward after every power-of-two number of steps. Unlike
+        // keeping the chain around for Floyd's, this needs no storage, so
+        // printing never allocates.
+        const Node *Saved = nullptr;
+        size_t Steps = 0;
+        size_t Power = 1;
         for (;;)
         {
             const Node *SN = SoFar.second->getSyntaxNode(OB);
@@ -880,14 +927,18 @@ class ReferenceType : public Node
             SoFar.second = RT->Pointee;
             SoFar.first = std::min(SoFar.first, RT->RK);
 
-            // The middle of Prev is the 'slow' pointer moving at half speed
-            Prev.push_back(SoFar.second);
-            if (Prev.size() > 1 && SoFar.second == Prev[(Prev.size() - 1) / 2])
+            if (SoFar.second == Saved)
             {
                 // Cycle detected
                 SoFar.second = nullptr;
                 break;
             }
+            if (++Steps == Power)
+            {
+                Saved = SoFar.second;
+                Power *= 2;
+                Steps = 0;
+            }
         }
         return SoFar;
     }
@@ -3145,6 +3196,8 @@ struct AbstractManglingParser
             Parser(TheParser),
             OldNumTemplateParamLists(TheParser->TemplateParams.size())
         {
+            if (Parser->Scratch != nullptr)
+                Params.useScratch(*Parser->Scratch);
             Parser->TemplateParams.push_back(&Params);
         }
         ~ScopedTemplateParamList()
@@ -3176,6 +3229,9 @@ struct AbstractManglingParser
 
     unsigned NumSyntheticTemplateParameters[3] = {};
 
+    // Where the tables above grow when demangling without the heap.
+    ScratchRegion *Scratch = nullptr;
+
     Alloc ASTAllocator;
 
     AbstractManglingParser(const char *First_, const char *Last_) :
@@ -3193,6 +3249,8 @@ struct AbstractManglingParser
         Names.clear();
         Subs.clear();
         TemplateParams.clear();
+        OuterTemplateParams.clear();
+        ForwardTemplateRefs.clear();
         ParsingLambdaParamsAtLevel = (size_t)-1;
         TryToParseTemplateArgs = true;
         PermitForwardTemplateReferences = false;
@@ -3201,6 +3259,46 @@ struct AbstractManglingParser
         ASTAllocator.reset();
     }
 
+    // Keep the tables above in Region rather than on the heap; the AST is up
+    // to the allocator.
+    void useScratch(ScratchRegion &Region)
+    {
+        Scratch = &Region;
+        Names.useScratch(Region);
+        Subs.useScratch(Region);
+        OuterTemplateParams.useScratch(Region);
+        TemplateParams.useScratch(Region);
+        ForwardTemplateRefs.useScratch(Region);
+    }
+
+    // Empty the tables above, keeping up to Budget bytes of the heap memory
+    // they grew into for the next parse and releasing the rest. Returns how
+    // much was kept.
+    size_t trimTables(size_t Budget)
+    {
+        size_t Kept = 0;
+        trimTable(Names, Budget, Kept);
+        trimTable(Subs, Budget, Kept);
+        trimTable(OuterTemplateParams, Budget, Kept);
+        trimTable(TemplateParams, Budget, Kept);
+        trimTable(ForwardTemplateRefs, Budget, Kept);
+        return Kept;
+    }
+
+private:
+    template<class Table>
+    static void trimTable(Table &T, size_t Budget, size_t &Kept)
+    {
+        T.clear();
+        size_t Size = T.heapCapacity();
+        if (Kept + Size <= Budget)
+            Kept += Size;
+        else
+            T.shrinkToInline();
+    }
+
+public:
+
     template<class T, class... Args>
     Node *make(Args &&...args)
     {
@@ -3212,6 +3310,8 @@ struct AbstractManglingParser
     {
         size_t sz = static_cast<size_t>(end - begin);
         void *mem = ASTAllocator.allocateNodeArray(sz);
+        if (mem == nullptr)
+            return NodeArray();
         Node **data = new (mem) Node *[sz];
         std::copy(begin, end, data);
         return NodeArray(data, sz);
@@ -6362,7 +6462,9 @@ Node *AbstractManglingParser<Derived, Alloc>::parseTemplateParamDecl()
     {
         unsigned Index = NumSyntheticTemplateParameters[(int)Kind]++;
         Node *N = make<SyntheticTemplateParamName>(Kind, Index);
-        if (N)
+        // The list for this scope can only be missing if scratch memory ran
+        // out, and then the result is thrown away anyway.
+        if (N && TemplateParams.back())
             TemplateParams.back()->push_back(N);
         return N;
     };
@@ -37,6 +37,18 @@ namespace llvm
 
             void addNode(size_t Capacity)
             {
+                // Reuse a block that reset() kept, if one is big enough.
+                for (AllocatorNode **Link = &Spare; *Link; Link = &(*Link)->Next)
+                {
+                    AllocatorNode *Node = *Link;
+                    if (Node->Capacity < Capacity)
+                        continue;
+                    *Link = Node->Next;
+                    Node->Next = Head;
+                    Node->Used = 0;
+                    Head = Node;
+                    return;
+                }
                 AllocatorNode *NewHead = new AllocatorNode;
                 NewHead->Buf = new uint8_t[Capacity];
                 NewHead->Next = Head;
@@ -45,22 +57,63 @@ namespace llvm
                 NewHead->Used = 0;
             }
 
+            static void freeNodes(AllocatorNode *Node)
+            {
+                while (Node)
+                {
+                    assert(Node->Buf);
+                    delete[] Node->Buf;
+                    AllocatorNode *Next = Node->Next;
+                    delete Node;
+                    Node = Next;
+                }
+            }
+
         public:
             ArenaAllocator()
             {
                 addNode(AllocUnit);
             }
 
+            // A fixed-size arena for demangling without the heap: all memory
+            // comes out of the Size bytes at Buf, which is never grown or
+            // freed. Once it runs out, every allocation returns nullptr and
+            // Failed is set, so callers check for nullptr and give up the way
+            // they do on a malformed name.
+            ArenaAllocator(void *Buf, size_t Size, bool &Failed) :
+                Fixed(true), Failed(&Failed)
+            {
+                FixedNode.Buf = static_cast<uint8_t *>(Buf);
+                FixedNode.Capacity = Size;
+                Head = &FixedNode;
+            }
+
             ~ArenaAllocator()
             {
-                while (Head)
+                if (Fixed)
+                    return;
+                freeNodes(Head);
+                freeNodes(Spare);
+            }
+
+            // Free everything allocated so far, but keep the blocks it was
+            // allocated from for reuse.
+            void reset()
+            {
+                Exhausted = false;
+                if (Fixed)
                 {
-                    assert(Head->Buf);
-                    delete[] Head->Buf;
-                    AllocatorNode *Next = Head->Next;
-                    delete Head;
-                    Head = Next;
+                    FixedNode.Used = 0;
+                    return;
                 }
+                while (Head->Next)
+                {
+                    AllocatorNode *Node = Head;
+                    Head = Head->Next;
+                    Node->Next = Spare;
+                    Spare = Node;
+                }
+                Head->Used = 0;
             }
 
             char *allocUnalignedBuffer(size_t Size)
@@ -73,6 +126,11 @@ namespace llvm
                 if (Head->Used <= Head->Capacity)
                     return reinterpret_cast<char *>(P);
 
+                if (Fixed)
+                {
+                    setExhausted();
+                    return nullptr;
+                }
                 addNode(std::max(AllocUnit, Size));
                 Head->Used = Size;
                 return reinterpret_cast<char *>(Head->Buf);
@@ -94,6 +152,11 @@ namespace llvm
                 if (Head->Used <= Head->Capacity)
                     return new (PP) T[Count]();
 
+                if (Fixed)
+                {
+                    setExhausted();
+                    return nullptr;
+                }
                 addNode(std::max(AllocUnit, Size));
                 Head->Used = Size;
                 return new (Head->Buf) T[Count]();
@@ -115,14 +178,59 @@ namespace llvm
                 if (Head->Used <= Head->Capacity)
                     return new (PP) T(std::forward<Args>(ConstructorArgs)...);
 
+                if (Fixed)
+                {
+                    setExhausted();
+                    return nullptr;
+                }
                 static_assert(Size < AllocUnit);
                 addNode(AllocUnit);
                 Head->Used = Size;
                 return new (Head->Buf) T(std::forward<Args>(ConstructorArgs)...);
             }
 
+            // The unused end of the current block, for printing into in place.
+            // Claim what was used with allocUnalignedBuffer().
+            char *freeSpace(size_t &Size)
+            {
+                assert(Head && Head->Buf);
+                Size = Head->Used < Head->Capacity ? Head->Capacity - Head->Used : 0;
+                return reinterpret_cast<char *>(Head->Buf + Head->Used);
+            }
+
+            // Make sure the current block has at least Size bytes free, moving
+            // on to a new one if needed. Returns false if a fixed-size arena
+            // doesn't have them.
+            bool reserve(size_t Size)
+            {
+                assert(Head && Head->Buf);
+                if (Head->Used + Size <= Head->Capacity)
+                    return true;
+                if (Fixed)
+                    return false;
+                addNode(std::max(AllocUnit, Size));
+                return true;
+            }
+
+            // Only fixed-size arenas run out.
+            void setExhausted()
+            {
+                Exhausted = true;
+                *Failed = true;
+            }
+
+            bool exhausted() const
+            {
+                return Exhausted;
+            }
+
         private:
             AllocatorNode *Head = nullptr;
+            AllocatorNode *Spare = nullptr;
+            AllocatorNode FixedNode;
+            bool Fixed = false;
+            bool Exhausted = false;
+            bool *Failed = nullptr;
         };
 
         struct BackrefContext
@@ -134,10 +242,85 @@ namespace llvm
 
             // The first 10 BackReferences in a mangled name can be back-referenced by
             // special name @[0-9]. This is a storage for the first 10 BackReferences.
+            // NameHashes lets memorizeString() skip most of the string compares.
             NamedIdentifierNode *Names[Max];
+            uint32_t NameHashes[Max];
             size_t NamesCount = 0;
         };
 
+        // The nodes of the lists being parsed (name scopes, parameters, array
+        // dimensions). Lists nest, so each one notes size() when it starts,
+        // pushes its nodes and then pops them into a NodeArrayNode. It starts
+        // out inline and grows into the arena.
+        class NodeStack
+        {
+            static constexpr size_t InlineCapacity = 32;
+
+            Node *Inline[InlineCapacity];
+            Node **Grown = nullptr;
+            size_t Size = 0;
+            size_t Capacity = InlineCapacity;
+
+            Node **data()
+            {
+                return Grown ? Grown : Inline;
+            }
+
+        public:
+            size_t size() const
+            {
+                return Size;
+            }
+
+            // Returns false if a fixed-size arena runs out.
+            bool push(ArenaAllocator &Arena, Node *N)
+            {
+                if (Size == Capacity)
+                {
+                    Node **NewNodes = Arena.allocArray<Node *>(Capacity * 2);
+                    if (NewNodes == nullptr)
+                        return false;
+                    Node **Old = data();
+                    for (size_t I = 0; I < Size; ++I)
+                        NewNodes[I] = Old[I];
+                    Grown = NewNodes;
+                    Capacity *= 2;
+                }
+                data()[Size++] = N;
+                return true;
+            }
+
+            // Pops the nodes pushed since size() was Begin, in push order.
+            NodeArrayNode *popArray(ArenaAllocator &Arena, size_t Begin)
+            {
+                assert(Begin <= Size);
+                size_t Count = Size - Begin;
+                Size = Begin;
+
+                NodeArrayNode *N = Arena.alloc<NodeArrayNode>();
+                // Out of scratch memory; the demangler has failed already.
+                if (N == nullptr)
+                    return nullptr;
+                N->Count = Count;
+                N->Nodes = Arena.allocArray<Node *>(Count);
+                // Out of scratch memory; the demangler has failed already.
+                if (N->Nodes == nullptr)
+                    return N;
+                Node **Nodes = data() + Begin;
+                for (size_t I = 0; I < Count; ++I)
+                    N->Nodes[I] = Nodes[I];
+                return N;
+            }
+
+            // Forget everything; the arena is being reset.
+            void clear()
+            {
+                Grown = nullptr;
+                Size = 0;
+                Capacity = InlineCapacity;
+            }
+        };
+
         enum class QualifierMangleMode
         {
             Drop,
@@ -166,8 +349,15 @@ namespace llvm
         {
         public:
             Demangler() = default;
+            // Demangles without the heap, using the Size bytes at Scratch for
+            // all memory. A quarter of it is set aside for rendering names.
+            Demangler(void *Scratch, size_t Size);
             virtual ~Demangler() = default;
 
+            // Get ready to parse another symbol, reusing the memory allocated
+            // so far. Everything parse() returned before becomes invalid.
+            void reset();
+
             // You are supposed to call parse() first and then check if error is true.  If
             // it is false, call output() to write the formatted name to the given stream.
             SymbolNode *parse(StringView &MangledName);
@@ -177,6 +367,13 @@ namespace llvm
             // True if an error occurred.
             bool Error = false;
 
+            // True if a heap-free Demangler ran out of scratch memory. Error is
+            // set as well.
+            bool outOfScratch() const
+            {
+                return Arena.exhausted();
+            }
+
         private:
             SymbolNode *demangleEncodedSymbol(StringView &MangledName,
                 QualifiedNameNode *QN);
@@ -245,6 +442,8 @@ namespace llvm
             demangleLiteralOperatorIdentifier(StringView &MangledName);
 
             SymbolNode *demangleSpecialIntrinsic(StringView &MangledName);
+            SymbolNode *demangleSpecialIntrinsic(StringView &MangledName,
+                SpecialIntrinsicKind SIK);
             SpecialTableSymbolNode *
             demangleSpecialTableSymbolNode(StringView &MangledName,
                 SpecialIntrinsicKind SIK);
@@ -280,6 +479,12 @@ namespace llvm
             // Memory allocator.
             ArenaAllocator Arena;
 
+            // Fixed buffer for rendering names before they are copied into the
+            // arena, for heap-free Demanglers. Otherwise those buffers are
+            // malloc()ed.
+            char *TempBuf = nullptr;
+            size_t TempBufSize = 0;
+
             // A single type uses one global back-ref table for all function params.
             // This means back-refs can even go "into" other types.  Examples:
             //
@@ -294,6 +499,9 @@ namespace llvm
             //  using F = void(*)(int*);
             //  F G(int *);
             BackrefContext Backrefs;
+
+            // Scratch space for the lists being parsed.
+            NodeStack Lists;
         };
 
     } // namespace ms_demangle
@@ -104,6 +104,10 @@ namespace llvm
             OF_NoMemberType = 8,
             OF_NoReturnType = 16,
             OF_NoVariableType = 32,
+            // Leave out the template arguments of the identifier being
+            // printed, and of the class a constructor or destructor is
+            // named after. Names nested inside it still get theirs.
+            OF_NoTemplateParameters = 64,
         };
 
         // Types
@@ -291,6 +295,9 @@ namespace llvm
             SpecialTableSymbol
         };
 
+        // Prints the keyword for CC, such as "__cdecl".
+        void outputCallingConvention(OutputBuffer &OB, CallingConv CC);
+
         struct Node
         {
             explicit Node(NodeKind K) :
@@ -406,7 +413,6 @@ namespace llvm
 
             NodeArrayNode *TemplateParams = nullptr;
 
-        protected:
             void outputTemplateParameters(OutputBuffer &OB, OutputFlags Flags) const;
         };
 
@@ -661,6 +667,10 @@ namespace llvm
                 Node(K) { }
             void output(OutputBuffer &OB, OutputFlags Flags) const override;
             QualifiedNameNode *Name = nullptr;
+
+            // Which special name this is, if it was mangled as one (vftables,
+            // RTTI data, thunks and so on).
+            SpecialIntrinsicKind SpecialKind = SpecialIntrinsicKind::None;
         };
 
         struct SpecialTableSymbolNode : public SymbolNode
@@ -34,12 +34,89 @@ class OutputBuffer
     size_t CurrentPosition = 0;
     size_t BufferCapacity = 0;
 
-    // Ensure there are at least N more positions in the buffer.
-    void grow(size_t N)
+    // insert() and prepend() leave a gap behind the inserted text instead of
+    // shifting the tail of the buffer every time. While a gap is open the
+    // contents are Buffer[0, GapStart) followed by
+    // Buffer[GapStart + GapSize, CurrentPosition + GapSize), so a run of
+    // insertions at or near the same position only moves the bytes between
+    // consecutive insertion points. Every other operation flattens the buffer
+    // first, which happens once at the end of such a run.
+    mutable size_t GapStart = 0;
+    mutable size_t GapSize = 0;
+
+    // A fixed-size buffer never reallocates. Output that doesn't fit is cut
+    // off at the end, and from then on the buffer is truncated: appends and
+    // rewinds are ignored and insertions push what follows them off the end,
+    // so it keeps a prefix of what was printed.
+    bool FixedSize = false;
+    bool Truncated = false;
+
+    // A counting buffer only measures the output. Buffer is a small window
+    // holding the most recent output, enough for back() and the short rewinds
+    // printing does; Dropped counts what slid out of it. If the window turns
+    // out to be too small, the count is marked inexact.
+    bool Counting = false;
+    mutable bool Inexact = false;
+    size_t Dropped = 0;
+
+    // Make room for N more bytes in the window of a counting buffer, keeping
+    // some of its tail. Returns false if the bytes can only be counted.
+    bool slideWindow(size_t N)
     {
+        if (N > BufferCapacity)
+        {
+            Dropped += CurrentPosition + N;
+            CurrentPosition = 0;
+            return false;
+        }
+        size_t Keep = CurrentPosition;
+        if (Keep > BufferCapacity / 2)
+            Keep = BufferCapacity / 2;
+        if (Keep > BufferCapacity - N)
+            Keep = BufferCapacity - N;
+        std::memmove(Buffer, Buffer + CurrentPosition - Keep, Keep);
+        Dropped += CurrentPosition - Keep;
+        CurrentPosition = Keep;
+        return true;
+    }
+
+    // Close the gap, if any. This doesn't change the logical contents of the
+    // buffer, only where the tail is stored.
+    void flatten() const
+    {
+        if (GapSize == 0)
+            return;
+        std::memmove(Buffer + GapStart, Buffer + GapStart + GapSize,
+            CurrentPosition - GapStart);
+        GapSize = 0;
+    }
+
+    // Move the gap so that it starts at logical position Pos.
+    void moveGap(size_t Pos)
+    {
+        if (Pos < GapStart)
+            std::memmove(Buffer + Pos + GapSize, Buffer + Pos, GapStart - Pos);
+        else if (Pos > GapStart)
+            std::memmove(Buffer + GapStart, Buffer + GapStart + GapSize,
+                Pos - GapStart);
+        GapStart = Pos;
+    }
+
+    // Ensure there are at least N more positions in the buffer. Returns false
+    // if they can't be had because the buffer is fixed-size and truncated.
+    bool grow(size_t N)
+    {
+        flatten();
         size_t Need = N + CurrentPosition;
         if (Need > BufferCapacity)
         {
+            if (FixedSize)
+            {
+                Truncated = true;
+                return false;
+            }
+            if (Counting)
+                return slideWindow(N);
             // Reduce the number of reallocations, with a bit of hysteresis. The
             // number here is chosen so the first allocation will more-than-likely not
             // allocate more than 1K.
@@ -51,6 +128,7 @@ class OutputBuffer
             if (Buffer == nullptr)
                 std::terminate();
         }
+        return !Truncated;
     }
 
     OutputBuffer &writeUnsigned(uint64_t N, bool isNeg = false)
@@ -77,6 +155,16 @@ public:
         Buffer(StartBuf), BufferCapacity(Size) { }
     OutputBuffer(char *StartBuf, size_t *SizePtr) :
         OutputBuffer(StartBuf, StartBuf ? *SizePtr : 0) { }
+    // A buffer that never grows past Size bytes, see isTruncated().
+    OutputBuffer(char *StartBuf, size_t Size, bool FixedSize_) :
+        Buffer(StartBuf), BufferCapacity(Size), FixedSize(FixedSize_) { }
+    // A buffer that only counts how much is printed into it, see isExact().
+    // Window is scratch space for it; a few hundred bytes is plenty.
+    struct CountOnly
+    {
+    };
+    OutputBuffer(CountOnly, char *Window, size_t Size) :
+        Buffer(Window), BufferCapacity(Size), Counting(true) { }
     OutputBuffer() = default;
     // Non-copyable
     OutputBuffer(const OutputBuffer &) = delete;
@@ -84,6 +172,7 @@ public:
 
     operator StringView() const
     {
+        flatten();
         return StringView(Buffer, CurrentPosition);
     }
 
@@ -116,7 +205,20 @@ public:
     {
         if (size_t Size = R.size())
         {
-            grow(Size);
+            bool WasTruncated = Truncated;
+            if (!grow(Size))
+            {
+                // A fixed-size buffer that runs out here keeps the part that
+                // fits, so that it holds as long a prefix as it can.
+                if (FixedSize && !WasTruncated &&
+                    CurrentPosition != BufferCapacity)
+                {
+                    Size = BufferCapacity - CurrentPosition;
+                    std::memcpy(Buffer + CurrentPosition, R.begin(), Size);
+                    CurrentPosition += Size;
+                }
+                return *this;
+            }
             std::memcpy(Buffer + CurrentPosition, R.begin(), Size);
             CurrentPosition += Size;
         }
@@ -125,20 +227,15 @@ public:
 
     OutputBuffer &operator+=(char C)
     {
-        grow(1);
+        if (!grow(1))
+            return *this;
         Buffer[CurrentPosition++] = C;
         return *this;
     }
 
     OutputBuffer &prepend(StringView R)
     {
-        size_t Size = R.size();
-
-        grow(Size);
-        std::memmove(Buffer + Size, Buffer, CurrentPosition);
-        std::memcpy(Buffer, R.begin(), Size);
-        CurrentPosition += Size;
-
+        insert(0, R.begin(), R.size());
         return *this;
     }
 
@@ -184,47 +281,196 @@ public:
 
     void insert(size_t Pos, const char *S, size_t N)
     {
-        assert(Pos <= CurrentPosition);
         if (N == 0)
             return;
-        grow(N);
-        std::memmove(Buffer + Pos + N, Buffer + Pos, CurrentPosition - Pos);
-        std::memcpy(Buffer + Pos, S, N);
+        if (Counting)
+        {
+            // The window can't represent an insertion before its end.
+            Inexact = true;
+            Dropped += N;
+            return;
+        }
+        if (FixedSize && (Truncated || N > BufferCapacity - CurrentPosition))
+        {
+            // Keep what fits of the output with S in it. Whatever is pushed
+            // past the end is lost like an append that doesn't fit, so the
+            // buffer still holds a prefix of the whole output.
+            flatten();
+            Truncated = true;
+            if (Pos >= BufferCapacity || Pos > CurrentPosition)
+                return;
+            size_t Room = BufferCapacity - Pos;
+            if (N > Room)
+                N = Room;
+            size_t Tail = CurrentPosition - Pos;
+            if (Tail > Room - N)
+                Tail = Room - N;
+            std::memmove(Buffer + Pos + N, Buffer + Pos, Tail);
+            std::memcpy(Buffer + Pos, S, N);
+            CurrentPosition = Pos + N + Tail;
+            return;
+        }
+        assert(Pos <= CurrentPosition);
+        if (GapSize < N)
+        {
+            // Reopen the gap over all of the free space, so that the next
+            // insertions don't have to touch the tail again.
+            if (!grow(N))
+                return;
+            GapStart = CurrentPosition;
+            GapSize = BufferCapacity - CurrentPosition;
+        }
+        moveGap(Pos);
+        std::memcpy(Buffer + GapStart, S, N);
+        GapStart += N;
+        GapSize -= N;
         CurrentPosition += N;
     }
 
+    // Print again the N bytes printed at Pos. Returns false, printing nothing,
+    // if a fixed-size buffer doesn't have room for all of them; printing them
+    // piece by piece would keep a longer prefix.
+    bool repeat(size_t Pos, size_t N)
+    {
+        assert(!Counting);
+        if (N == 0 || Truncated)
+            return true;
+        if (FixedSize && N > BufferCapacity - CurrentPosition)
+            return false;
+        if (!grow(N))
+            return true;
+        assert(Pos + N <= CurrentPosition);
+        std::memcpy(Buffer + CurrentPosition, Buffer + Pos, N);
+        CurrentPosition += N;
+        return true;
+    }
+
     size_t getCurrentPosition() const
     {
-        return CurrentPosition;
+        return Dropped + CurrentPosition;
     }
     void setCurrentPosition(size_t NewPos)
     {
-        CurrentPosition = NewPos;
+        flatten();
+        if (Truncated)
+            return;
+        if (NewPos < Dropped)
+        {
+            // Rewound past the window of a counting buffer.
+            Inexact = true;
+            Dropped = NewPos;
+        }
+        CurrentPosition = NewPos - Dropped;
     }
 
     char back() const
     {
+        // What was printed last may have been dropped from a truncated buffer,
+        // or slid out of the window of a counting one.
+        if (Truncated && CurrentPosition == 0)
+            return '\0';
+        if (Counting && CurrentPosition == 0 && Dropped != 0)
+        {
+            Inexact = true;
+            return '\0';
+        }
         assert(CurrentPosition);
-        return Buffer[CurrentPosition - 1];
+        if (GapSize != 0 && GapStart == CurrentPosition)
+            return Buffer[GapStart - 1];
+        return Buffer[CurrentPosition + GapSize - 1];
     }
 
     bool empty() const
     {
-        return CurrentPosition == 0;
+        return Dropped + CurrentPosition == 0;
     }
 
     char *getBuffer()
     {
+        flatten();
         return Buffer;
     }
     char *getBufferEnd()
     {
+        flatten();
         return Buffer + CurrentPosition - 1;
     }
     size_t getBufferCapacity() const
     {
         return BufferCapacity;
     }
+
+    /// True if this is a fixed-size buffer and some output didn't fit.
+    bool isTruncated() const
+    {
+        return Truncated;
+    }
+
+    /// For a counting buffer, true if getCurrentPosition() is the exact length
+    /// of what was printed.
+    bool isExact() const
+    {
+        return !Inexact;
+    }
+};
+
+// Measures what Print writes into an OutputBuffer and, if the count is exact,
+// returns a malloc()ed buffer with room for it plus a terminator, setting Size
+// to that. Otherwise returns nullptr and the caller prints into a growing
+// buffer as usual.
+template<class Fn>
+char *allocateExactBuffer(Fn Print, size_t &Size)
+{
+    char Window[256];
+    OutputBuffer Counter(OutputBuffer::CountOnly(), Window, sizeof(Window));
+    Print(Counter);
+    if (!Counter.isExact())
+        return nullptr;
+    Size = Counter.getCurrentPosition() + 1;
+    char *Buf = static_cast<char *>(std::malloc(Size));
+    if (Buf == nullptr)
+        std::terminate();
+    return Buf;
+}
+
+// Caller-provided memory for demangling without the heap. Allocation bumps a
+// pointer, nothing is ever freed, and once a request doesn't fit the region
+// stays exhausted, so the caller can check afterwards whether anything was
+// missing.
+class ScratchRegion
+{
+    char *Ptr;
+    char *End;
+    bool Exhausted = false;
+
+public:
+    ScratchRegion(void *Buf, size_t Size) :
+        Ptr(static_cast<char *>(Buf)), End(Ptr + Size) { }
+
+    ScratchRegion(const ScratchRegion &) = delete;
+    ScratchRegion &operator=(const ScratchRegion &) = delete;
+
+    // Returns nullptr if there is no room left.
+    void *allocate(size_t N, size_t Align)
+    {
+        if (Exhausted)
+            return nullptr;
+        size_t Adjustment = (Align - reinterpret_cast<uintptr_t>(Ptr) % Align) % Align;
+        if (Adjustment > static_cast<size_t>(End - Ptr) ||
+            N > static_cast<size_t>(End - Ptr) - Adjustment)
+        {
+            Exhausted = true;
+            return nullptr;
+        }
+        char *P = Ptr + Adjustment;
+        Ptr = P + N;
+        return P;
+    }
+
+    bool exhausted() const
+    {
+        return Exhausted;
+    }
 };
 
 template<class T>
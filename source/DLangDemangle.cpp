@@ -23,6 +23,7 @@
 
 using namespace llvm;
 using llvm::itanium_demangle::OutputBuffer;
+using llvm::itanium_demangle::ScopedOverride;
 using llvm::itanium_demangle::StringView;
 
 namespace
@@ -34,7 +35,8 @@ namespace
         /// Initialize the information structure we use to pass around information.
         ///
         /// \param Mangled String to demangle.
-        Demangler(const char *Mangled);
+        /// \param Length Length of the string, which needn't be null-terminated.
+        Demangler(const char *Mangled, size_t Length);
 
         /// Extract and demangle the mangled symbol and append it to the output
         /// string.
@@ -95,6 +97,16 @@ namespace
         /// \see https://dlang.org/spec/abi.html#back_ref .
         const char *decodeBackref(const char *Mangled, const char *&Ret);
 
+        /// Extract a byte encoded as two hexadecimal digits from a given string.
+        ///
+        /// \param Mangled string to extract the byte.
+        /// \param Ret assigned result value.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#HexDigits .
+        const char *decodeHexDigit(const char *Mangled, char &Ret);
+
         /// Extract and demangle backreferenced symbol from a given mangled symbol
         /// and append it to the output string.
         ///
@@ -110,13 +122,16 @@ namespace
         /// Extract and demangle backreferenced type from a given mangled symbol
         /// and append it to the output string.
         ///
+        /// \param Demangled output buffer to write the demangled name.
         /// \param Mangled mangled symbol to be demangled.
+        /// \param IsFunction whether the back reference points to a function type.
         ///
         /// \return the remaining string on success or nullptr on failure.
         ///
         /// \see https://dlang.org/spec/abi.html#back_ref .
         /// \see https://dlang.org/spec/abi.html#TypeBackRef .
-        const char *parseTypeBackref(const char *Mangled);
+        const char *parseTypeBackref(OutputBuffer *Demangled, const char *Mangled,
+            bool IsFunction);
 
         /// Check whether it is the beginning of a symbol name.
         ///
@@ -127,6 +142,16 @@ namespace
         /// \see https://dlang.org/spec/abi.html#SymbolName .
         bool isSymbolName(const char *Mangled);
 
+        /// Check whether it is the beginning of a template instance name, after
+        /// its length if it has one.
+        ///
+        /// \param Mangled string to extract the template instance name.
+        ///
+        /// \return true on success, false otherwise.
+        ///
+        /// \see https://dlang.org/spec/abi.html#TemplateInstanceName .
+        bool isTemplateInstance(const char *Mangled) const;
+
         /// Extract and demangle an identifier from a given mangled symbol append it
         /// to the output string.
         ///
@@ -157,34 +182,394 @@ namespace
         ///
         /// \param Demangled Output buffer to write the demangled name.
         /// \param Mangled Mangled symbol to be demangled.
+        /// \param SuffixModifiers Whether to print the modifiers of the 'this'
+        /// parameter of member functions after their parameters.
         ///
         /// \return The remaining string on success or nullptr on failure.
         ///
         /// \see https://dlang.org/spec/abi.html#QualifiedName .
-        const char *parseQualified(OutputBuffer *Demangled, const char *Mangled);
+        const char *parseQualified(OutputBuffer *Demangled, const char *Mangled,
+            bool SuffixModifiers);
+
+        /// Extract and demangle the parameters encoded after a symbol name of a
+        /// qualified name and append them to the output string.
+        ///
+        /// \param Demangled Output buffer to write the demangled name.
+        /// \param Mangled Mangled symbol to be demangled.
+        /// \param SuffixModifiers Whether to print the modifiers of the 'this'
+        /// parameter after the parameters.
+        ///
+        /// \return The remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#SymbolFunctionName .
+        const char *parseSymbolFunction(OutputBuffer *Demangled,
+            const char *Mangled, bool SuffixModifiers);
 
         /// Extract and demangle a type from a given mangled symbol append it to
         /// the output string.
         ///
+        /// \param Demangled output buffer to write the demangled name.
         /// \param Mangled mangled symbol to be demangled.
         ///
         /// \return the remaining string on success or nullptr on failure.
         ///
         /// \see https://dlang.org/spec/abi.html#Type .
-        const char *parseType(const char *Mangled);
+        const char *parseType(OutputBuffer *Demangled, const char *Mangled);
+
+        /// Extract and demangle the type modifiers from a given mangled symbol
+        /// append them to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#TypeModifiers .
+        const char *parseTypeModifiers(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle the calling convention from a given mangled
+        /// symbol append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#CallConvention .
+        const char *parseCallConvention(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle the function attributes from a given mangled
+        /// symbol append them to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#FuncAttrs .
+        const char *parseAttributes(OutputBuffer *Demangled, const char *Mangled);
+
+        /// Extract and demangle the function parameters from a given mangled
+        /// symbol append them to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#Parameters .
+        const char *parseFunctionArgs(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle a function type from a given mangled symbol
+        /// append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#TypeFunction .
+        const char *parseFunctionType(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle a tuple type from a given mangled symbol append
+        /// it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#TypeTuple .
+        const char *parseTuple(OutputBuffer *Demangled, const char *Mangled);
+
+        /// Extract and demangle a template instance from a given mangled symbol
+        /// append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        /// \param Len Length of the template instance name, or
+        /// TemplateLengthUnknown if it isn't encoded.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#TemplateInstanceName .
+        const char *parseTemplate(OutputBuffer *Demangled, const char *Mangled,
+            unsigned long Len);
+
+        /// Extract and demangle the template arguments from a given mangled
+        /// symbol append them to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#TemplateArgs .
+        const char *parseTemplateArgs(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle a template symbol parameter from a given mangled
+        /// symbol append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#TemplateArg .
+        const char *parseTemplateSymbolParam(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle the symbol of a template symbol parameter that
+        /// starts at a given position and append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        const char *parseSymbolParamCandidate(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle a value from a given mangled symbol append it to
+        /// the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        /// \param Name mangled type of the value, printed before struct
+        /// literals, or nullptr.
+        /// \param Type first character of the mangled type of the value, or '\0'.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#Value .
+        const char *parseValue(OutputBuffer *Demangled, const char *Mangled,
+            const char *Name, char Type);
+
+        /// Extract and demangle an integral value from a given mangled symbol
+        /// append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        /// \param Type first character of the mangled type of the value.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        const char *parseInteger(OutputBuffer *Demangled, const char *Mangled,
+            char Type);
+
+        /// Extract and demangle a floating point value from a given mangled
+        /// symbol append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        ///
+        /// \see https://dlang.org/spec/abi.html#HexFloat .
+        const char *parseReal(OutputBuffer *Demangled, const char *Mangled);
+
+        /// Extract and demangle a string literal from a given mangled symbol
+        /// append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        const char *parseString(OutputBuffer *Demangled, const char *Mangled);
+
+        /// Extract and demangle an array literal from a given mangled symbol
+        /// append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        const char *parseArrayLiteral(OutputBuffer *Demangled,
+            const char *Mangled);
+
+        /// Extract and demangle an associative array literal from a given
+        /// mangled symbol append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        const char *parseAssocArray(OutputBuffer *Demangled, const char *Mangled);
+
+        /// Extract and demangle a struct literal from a given mangled symbol
+        /// append it to the output string.
+        ///
+        /// \param Demangled output buffer to write the demangled name.
+        /// \param Mangled mangled symbol to be demangled.
+        /// \param Name mangled type of the struct, or nullptr.
+        ///
+        /// \return the remaining string on success or nullptr on failure.
+        const char *parseStructLiteral(OutputBuffer *Demangled,
+            const char *Mangled, const char *Name);
+
+        /// The character at Mangled, or '\0' at the end of the string.
+        char peek(const char *Mangled) const;
+
+        /// Check whether what is appended to the output string is thrown away,
+        /// in which case nothing needs to be parsed twice to be printed in a
+        /// different order than it is mangled in.
+        bool discards(const OutputBuffer *Demangled) const;
 
         /// The string we are demangling.
         const char *Str;
+        /// The end of the string we are demangling.
+        const char *End;
         /// The index of the last back reference.
-        int LastBackref;
+        size_t LastBackref;
+
+        /// How deeply types, values and identifiers are nested where we are.
+        size_t RecursionLevel = 0;
+        static constexpr size_t MaxRecursionLevel = 500;
+
+        /// Parts of the symbol that are printed in a different order than they
+        /// are mangled in are first parsed into this, to find where they end.
+        /// It has no room, so nothing is kept.
+        OutputBuffer Discard;
+
+        /// A type a back reference pointed to that parsed successfully, and
+        /// the LastBackref it was parsed with. Parsing it again with a later
+        /// one succeeds too, so it needn't be unless it is printed.
+        struct TypeBackref
+        {
+            const char *Type = nullptr;
+            bool IsFunction = false;
+            size_t LastBackref = 0;
+        };
+        static constexpr size_t TypeBackrefCacheSize = 16;
+        TypeBackref TypeBackrefs[TypeBackrefCacheSize];
+
+        /// Where the symbol of an ambiguous template symbol parameter starting
+        /// at Start was found to start and end when it was parsed with
+        /// LastBackref, or nullptr if it wasn't. Finding it means parsing the
+        /// parameters nested in it once per try.
+        struct SymbolParam
+        {
+            const char *Start = nullptr;
+            size_t LastBackref = 0;
+            const char *Symbol = nullptr;
+            const char *Rest = nullptr;
+        };
+        static constexpr size_t SymbolParamCacheSize = 16;
+        SymbolParam SymbolParams[SymbolParamCacheSize];
+
+        /// How many times the symbol of an ambiguous template symbol parameter
+        /// was tried. Nesting them can still make that exponential, so past a
+        /// limit the whole symbol is given up on.
+        size_t SymbolParamTrials = 0;
+        static constexpr size_t MaxSymbolParamTrials = 4096;
     };
 
 } // namespace
 
+/// The length of a template instance name that has no encoded length.
+static constexpr unsigned long TemplateLengthUnknown =
+    std::numeric_limits<unsigned long>::max();
+
+static bool isCallConvention(char C)
+{
+    switch (C)
+    {
+        case 'F': // D
+        case 'U': // C
+        case 'W': // Windows
+        case 'V': // Pascal
+        case 'R': // C++
+        case 'Y': // Objective-C
+            return true;
+        default:
+            return false;
+    }
+}
+
+static StringView basicTypeName(char C)
+{
+    switch (C)
+    {
+        case 'n':
+            return "typeof(null)";
+        case 'v':
+            return "void";
+        case 'g':
+            return "byte";
+        case 'h':
+            return "ubyte";
+        case 's':
+            return "short";
+        case 't':
+            return "ushort";
+        case 'i':
+            return "int";
+        case 'k':
+            return "uint";
+        case 'l':
+            return "long";
+        case 'm':
+            return "ulong";
+        case 'f':
+            return "float";
+        case 'd':
+            return "double";
+        case 'e':
+            return "real";
+
+        // Imaginary and complex types.
+        case 'o':
+            return "ifloat";
+        case 'p':
+            return "idouble";
+        case 'j':
+            return "ireal";
+        case 'q':
+            return "cfloat";
+        case 'r':
+            return "cdouble";
+        case 'c':
+            return "creal";
+
+        // Other types.
+        case 'b':
+            return "bool";
+        case 'a':
+            return "char";
+        case 'u':
+            return "wchar";
+        case 'w':
+            return "dchar";
+
+        default:
+            return StringView();
+    }
+}
+
+static int hexDigitValue(char C)
+{
+    if (std::isdigit(C))
+        return C - '0';
+    return (std::isupper(C) ? C - 'A' : C - 'a') + 10;
+}
+
+char Demangler::peek(const char *Mangled) const
+{
+    return Mangled != End ? *Mangled : '\0';
+}
+
+bool Demangler::discards(const OutputBuffer *Demangled) const
+{
+    return Demangled == &Discard || Demangled->isTruncated();
+}
+
 const char *Demangler::decodeNumber(const char *Mangled, unsigned long &Ret)
 {
     // Return nullptr if trying to extract something that isn't a digit.
-    if (Mangled == nullptr || !std::isdigit(*Mangled))
+    if (Mangled == nullptr || Mangled == End || !std::isdigit(*Mangled))
         return nullptr;
 
     unsigned long Val = 0;
@@ -199,9 +584,9 @@ const char *Demangler::decodeNumber(const char *Mangled, unsigned long &Ret)
 
         Val = Val * 10 + Digit;
         ++Mangled;
-    } while (std::isdigit(*Mangled));
+    } while (Mangled != End && std::isdigit(*Mangled));
 
-    if (*Mangled == '\0')
+    if (Mangled == End)
         return nullptr;
 
     Ret = Val;
@@ -211,7 +596,7 @@ const char *Demangler::decodeNumber(const char *Mangled, unsigned long &Ret)
 const char *Demangler::decodeBackrefPos(const char *Mangled, long &Ret)
 {
     // Return nullptr if trying to extract something that isn't a digit
-    if (Mangled == nullptr || !std::isalpha(*Mangled))
+    if (Mangled == nullptr || Mangled == End || !std::isalpha(*Mangled))
         return nullptr;
 
     // Any identifier or non-basic type that has been emitted to the mangled
@@ -226,7 +611,7 @@ const char *Demangler::decodeBackrefPos(const char *Mangled, long &Ret)
     //        ^
     unsigned long Val = 0;
 
-    while (std::isalpha(*Mangled))
+    while (Mangled != End && std::isalpha(*Mangled))
     {
         // Check for overflow
         if (Val > (std::numeric_limits<unsigned long>::max() - 25) / 26)
@@ -273,6 +658,18 @@ const char *Demangler::decodeBackref(const char *Mangled, const char *&Ret)
     return Mangled;
 }
 
+const char *Demangler::decodeHexDigit(const char *Mangled, char &Ret)
+{
+    // Return nullptr if trying to extract something that isn't a hexdigit.
+    if (Mangled == nullptr || End - Mangled < 2 || !std::isxdigit(Mangled[0])
+        || !std::isxdigit(Mangled[1]))
+        return nullptr;
+
+    Ret = static_cast<char>(hexDigitValue(Mangled[0]) << 4
+        | hexDigitValue(Mangled[1]));
+    return Mangled + 2;
+}
+
 const char *Demangler::parseSymbolBackref(OutputBuffer *Demangled,
     const char *Mangled)
 {
@@ -288,7 +685,7 @@ const char *Demangler::parseSymbolBackref(OutputBuffer *Demangled,
 
     // Must point to a simple identifier
     Backref = decodeNumber(Backref, Len);
-    if (Backref == nullptr || strlen(Backref) < Len)
+    if (Backref == nullptr || static_cast<size_t>(End - Backref) < Len)
         return nullptr;
 
     Backref = parseLName(Demangled, Backref, Len);
@@ -298,7 +695,8 @@ const char *Demangler::parseSymbolBackref(OutputBuffer *Demangled,
     return Mangled;
 }
 
-const char *Demangler::parseTypeBackref(const char *Mangled)
+const char *Demangler::parseTypeBackref(OutputBuffer *Demangled,
+    const char *Mangled, bool IsFunction)
 {
     // A type back reference always points to a letter.
     //    TypeBackRef:
@@ -308,12 +706,10 @@ const char *Demangler::parseTypeBackref(const char *Mangled)
 
     // If we appear to be moving backwards through the mangle string, then
     // bail as this may be a recursive back reference.
-    if (Mangled - Str >= LastBackref)
+    size_t RefPos = Mangled - Str;
+    if (RefPos >= LastBackref)
         return nullptr;
 
-    int SaveRefPos = LastBackref;
-    LastBackref = Mangled - Str;
-
     // Get position of the back reference.
     Mangled = decodeBackref(Mangled, Backref);
 
@@ -321,14 +717,26 @@ const char *Demangler::parseTypeBackref(const char *Mangled)
     if (Backref == nullptr)
         return nullptr;
 
-    // TODO: Add support for function type back references.
-    Backref = parseType(Backref);
+    TypeBackref &Memo = TypeBackrefs[(Backref - Str) % TypeBackrefCacheSize];
+    if (discards(Demangled) && Memo.Type == Backref
+        && Memo.IsFunction == IsFunction && Memo.LastBackref <= RefPos)
+        return Mangled;
+
+    size_t SaveRefPos = LastBackref;
+    LastBackref = RefPos;
+
+    // Must point to a type.
+    const char *TypeEnd = IsFunction ? parseFunctionType(Demangled, Backref)
+                                     : parseType(Demangled, Backref);
 
     LastBackref = SaveRefPos;
 
-    if (Backref == nullptr)
+    if (TypeEnd == nullptr)
         return nullptr;
 
+    Memo.Type = Backref;
+    Memo.IsFunction = IsFunction;
+    Memo.LastBackref = RefPos;
     return Mangled;
 }
 
@@ -337,10 +745,15 @@ bool Demangler::isSymbolName(const char *Mangled)
     long Ret;
     const char *Qref = Mangled;
 
+    if (Mangled == End)
+        return false;
+
     if (std::isdigit(*Mangled))
         return true;
 
-    // TODO: Handle template instances.
+    // Template instances without a length.
+    if (isTemplateInstance(Mangled))
+        return true;
 
     if (*Mangled != 'Q')
         return false;
@@ -352,6 +765,12 @@ bool Demangler::isSymbolName(const char *Mangled)
     return std::isdigit(Qref[-Ret]);
 }
 
+bool Demangler::isTemplateInstance(const char *Mangled) const
+{
+    StringView Name(Mangled, End);
+    return Name.startsWith("__T") || Name.startsWith("__U");
+}
+
 const char *Demangler::parseMangle(OutputBuffer *Demangled,
     const char *Mangled)
 {
@@ -366,16 +785,17 @@ const char *Demangler::parseMangle(OutputBuffer *Demangled,
     // a function or the type of a variable.
     Mangled += 2;
 
-    Mangled = parseQualified(Demangled, Mangled);
+    Mangled = parseQualified(Demangled, Mangled, /*SuffixModifiers=*/true);
 
     if (Mangled != nullptr)
     {
         // Artificial symbols end with 'Z' and have no type.
-        if (*Mangled == 'Z')
+        if (Mangled != End && *Mangled == 'Z')
             ++Mangled;
         else
         {
-            Mangled = parseType(Mangled);
+            // The declaration or return type isn't printed.
+            Mangled = parseType(&Discard, Mangled);
         }
     }
 
@@ -383,7 +803,7 @@ const char *Demangler::parseMangle(OutputBuffer *Demangled,
 }
 
 const char *Demangler::parseQualified(OutputBuffer *Demangled,
-    const char *Mangled)
+    const char *Mangled, bool SuffixModifiers)
 {
     // Qualified names are identifiers separated by their encoded length.
     // Nested functions also encode their argument types without specifying
@@ -404,11 +824,11 @@ const char *Demangler::parseQualified(OutputBuffer *Demangled,
     do
     {
         // Skip over anonymous symbols.
-        if (*Mangled == '0')
+        if (Mangled != End && *Mangled == '0')
         {
             do
                 ++Mangled;
-            while (*Mangled == '0');
+            while (Mangled != End && *Mangled == '0');
 
             continue;
         }
@@ -419,35 +839,91 @@ const char *Demangler::parseQualified(OutputBuffer *Demangled,
 
         Mangled = parseIdentifier(Demangled, Mangled);
 
+        // Consume the encoded arguments. However if this is not followed by
+        // the next encoded length or mangle type, then this is not a
+        // continuation of a qualified name, and the arguments are left for the
+        // caller.
+        if (Mangled != nullptr && Mangled != End
+            && (*Mangled == 'M' || isCallConvention(*Mangled)))
+        {
+            const char *Rest = parseSymbolFunction(&Discard, Mangled,
+                SuffixModifiers);
+            if (Rest != nullptr && Rest != End)
+            {
+                if (!discards(Demangled))
+                    parseSymbolFunction(Demangled, Mangled, SuffixModifiers);
+                Mangled = Rest;
+            }
+        }
+
     } while (Mangled && isSymbolName(Mangled));
 
     return Mangled;
 }
 
+const char *Demangler::parseSymbolFunction(OutputBuffer *Demangled,
+    const char *Mangled, bool SuffixModifiers)
+{
+    //    SymbolFunctionName:
+    //        SymbolName TypeFunctionNoReturn
+    //        SymbolName M TypeFunctionNoReturn
+    //        SymbolName M TypeModifiers TypeFunctionNoReturn
+    //                   ^
+    // The modifiers of the 'this' parameter come first, but are printed after
+    // the parameters.
+    const char *Modifiers = nullptr;
+    if (*Mangled == 'M')
+    {
+        Modifiers = ++Mangled;
+        Mangled = parseTypeModifiers(&Discard, Mangled);
+    }
+
+    // The calling convention and attributes aren't printed.
+    Mangled = parseCallConvention(&Discard, Mangled);
+    Mangled = parseAttributes(&Discard, Mangled);
+
+    *Demangled << '(';
+    Mangled = parseFunctionArgs(Demangled, Mangled);
+    *Demangled << ')';
+
+    if (SuffixModifiers && Modifiers != nullptr && !discards(Demangled))
+        parseTypeModifiers(Demangled, Modifiers);
+
+    return Mangled;
+}
+
 const char *Demangler::parseIdentifier(OutputBuffer *Demangled,
     const char *Mangled)
 {
     unsigned long Len;
 
-    if (Mangled == nullptr || *Mangled == '\0')
+    if (Mangled == nullptr || Mangled == End
+        || RecursionLevel >= MaxRecursionLevel)
         return nullptr;
 
+    ScopedOverride<size_t> SaveRecursionLevel(RecursionLevel,
+        RecursionLevel + 1);
+
     if (*Mangled == 'Q')
         return parseSymbolBackref(Demangled, Mangled);
 
-    // TODO: Parse lengthless template instances.
+    // May be a template instance without a length prefix.
+    if (isTemplateInstance(Mangled))
+        return parseTemplate(Demangled, Mangled, TemplateLengthUnknown);
 
     const char *Endptr = decodeNumber(Mangled, Len);
 
     if (Endptr == nullptr || Len == 0)
         return nullptr;
 
-    if (strlen(Endptr) < Len)
+    if (static_cast<size_t>(End - Endptr) < Len)
         return nullptr;
 
     Mangled = Endptr;
 
-    // TODO: Parse template instances with a length prefix.
+    // May be a template instance with a length prefix.
+    if (Len >= 5 && isTemplateInstance(Mangled))
+        return parseTemplate(Demangled, Mangled, Len);
 
     // There can be multiple different declarations in the same function that
     // have the same mangled name.  To make the mangled names unique, a fake
@@ -471,62 +947,1068 @@ const char *Demangler::parseIdentifier(OutputBuffer *Demangled,
     return parseLName(Demangled, Mangled, Len);
 }
 
-const char *Demangler::parseType(const char *Mangled)
+const char *Demangler::parseType(OutputBuffer *Demangled, const char *Mangled)
 {
-    if (*Mangled == '\0')
+    if (Mangled == nullptr || Mangled == End
+        || RecursionLevel >= MaxRecursionLevel)
         return nullptr;
 
+    ScopedOverride<size_t> SaveRecursionLevel(RecursionLevel,
+        RecursionLevel + 1);
+
     switch (*Mangled)
     {
-        // TODO: Parse type qualifiers.
-        // TODO: Parse function types.
-        // TODO: Parse compound types.
-        // TODO: Parse delegate types.
-        // TODO: Parse tuple types.
+        case 'O': // shared(T)
+            *Demangled << "shared(";
+            Mangled = parseType(Demangled, Mangled + 1);
+            *Demangled << ')';
+            return Mangled;
 
-        // Basic types.
-        case 'i':
+        case 'x': // const(T)
+            *Demangled << "const(";
+            Mangled = parseType(Demangled, Mangled + 1);
+            *Demangled << ')';
+            return Mangled;
+
+        case 'y': // immutable(T)
+            *Demangled << "immutable(";
+            Mangled = parseType(Demangled, Mangled + 1);
+            *Demangled << ')';
+            return Mangled;
+
+        case 'N':
             ++Mangled;
-            // TODO: Add type name dumping
+            switch (peek(Mangled))
+            {
+                case 'g': // wild(T)
+                    *Demangled << "inout(";
+                    Mangled = parseType(Demangled, Mangled + 1);
+                    *Demangled << ')';
+                    return Mangled;
+
+                case 'h': // vector(T)
+                    *Demangled << "__vector(";
+                    Mangled = parseType(Demangled, Mangled + 1);
+                    *Demangled << ')';
+                    return Mangled;
+
+                case 'n': // typeof(*null)
+                    *Demangled << "typeof(*null)";
+                    return Mangled + 1;
+
+                default:
+                    return nullptr;
+            }
+
+        case 'A': // dynamic array (T[])
+            Mangled = parseType(Demangled, Mangled + 1);
+            *Demangled << "[]";
             return Mangled;
 
-            // TODO: Add support for the rest of the basic types.
+        case 'G': // static array (T[N])
+        {
+            const char *Dimension = ++Mangled;
+            while (Mangled != End && std::isdigit(*Mangled))
+                ++Mangled;
+            StringView Size(Dimension, Mangled);
 
-        // Back referenced type.
-        case 'Q':
-            return parseTypeBackref(Mangled);
+            Mangled = parseType(Demangled, Mangled);
+            *Demangled << '[' << Size << ']';
+            return Mangled;
+        }
 
-        default: // unhandled.
-            return nullptr;
-    }
-}
+        case 'H': // associative array (T[T])
+        {
+            // The key type comes first, but is printed last.
+            const char *Key = ++Mangled;
+            Mangled = parseType(&Discard, Mangled);
+
+            Mangled = parseType(Demangled, Mangled);
+            *Demangled << '[';
+            if (Mangled != nullptr && !discards(Demangled))
+                parseType(Demangled, Key);
+            *Demangled << ']';
+            return Mangled;
+        }
 
-const char *Demangler::parseLName(OutputBuffer *Demangled, const char *Mangled,
-    unsigned long Len)
-{
-    switch (Len)
-    {
-        case 6:
-            if (strncmp(Mangled, "__initZ", Len + 1) == 0)
+        case 'P': // pointer (T*)
+            ++Mangled;
+            if (!isCallConvention(peek(Mangled)))
             {
-                // The static initializer for a given symbol.
-                Demangled->prepend("initializer for ");
-                Demangled->setCurrentPosition(Demangled->getCurrentPosition() - 1);
-                Mangled += Len;
+                Mangled = parseType(Demangled, Mangled);
+                *Demangled << '*';
                 return Mangled;
             }
-            if (strncmp(Mangled, "__vtblZ", Len + 1) == 0)
+            DEMANGLE_FALLTHROUGH;
+
+        case 'F': // function T (D)
+        case 'U': // function T (C)
+        case 'W': // function T (Windows)
+        case 'V': // function T (Pascal)
+        case 'R': // function T (C++)
+        case 'Y': // function T (Objective-C)
+            // Function pointer types don't include the trailing asterisk.
+            Mangled = parseFunctionType(Demangled, Mangled);
+            *Demangled << "function";
+            return Mangled;
+
+        case 'C': // class T
+        case 'S': // struct T
+        case 'E': // enum T
+        case 'T': // typedef T
+            return parseQualified(Demangled, Mangled + 1,
+                /*SuffixModifiers=*/false);
+
+        case 'D': // delegate T
+        {
+            // The modifiers come first, but are printed last.
+            const char *Modifiers = ++Mangled;
+            Mangled = parseTypeModifiers(&Discard, Mangled);
+
+            // Back referenced function type.
+            if (Mangled != nullptr && peek(Mangled) == 'Q')
+                Mangled = parseTypeBackref(Demangled, Mangled,
+                    /*IsFunction=*/true);
+            else
+                Mangled = parseFunctionType(Demangled, Mangled);
+
+            *Demangled << "delegate";
+            if (Mangled != nullptr && !discards(Demangled))
+                parseTypeModifiers(Demangled, Modifiers);
+            return Mangled;
+        }
+
+        case 'B': // tuple T
+            return parseTuple(Demangled, Mangled + 1);
+
+        case 'z':
+            ++Mangled;
+            switch (peek(Mangled))
             {
-                // The vtable symbol for a given class.
-                Demangled->prepend("vtable for ");
-                Demangled->setCurrentPosition(Demangled->getCurrentPosition() - 1);
-                Mangled += Len;
-                return Mangled;
+                case 'i':
+                    *Demangled << "cent";
+                    return Mangled + 1;
+
+                case 'k':
+                    *Demangled << "ucent";
+                    return Mangled + 1;
+
+                default:
+                    return nullptr;
             }
-            break;
+
+        // Back referenced type.
+        case 'Q':
+            return parseTypeBackref(Demangled, Mangled, /*IsFunction=*/false);
+
+        default:
+        {
+            // Basic types.
+            StringView Name = basicTypeName(*Mangled);
+            if (Name.empty())
+                return nullptr;
+
+            *Demangled << Name;
+            return Mangled + 1;
+        }
+    }
+}
+
+const char *Demangler::parseTypeModifiers(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    //    TypeModifiers:
+    //        Const
+    //        Wild
+    //        Wild Const
+    //        Shared
+    //        Shared Const
+    //        Shared Wild
+    //        Shared Wild Const
+    //        Immutable
+    while (Mangled != nullptr && Mangled != End)
+    {
+        switch (*Mangled)
+        {
+            case 'x': // const
+                *Demangled << " const";
+                return Mangled + 1;
+
+            case 'y': // immutable
+                *Demangled << " immutable";
+                return Mangled + 1;
+
+            case 'O': // shared
+                *Demangled << " shared";
+                ++Mangled;
+                continue;
+
+            case 'N':
+                if (peek(Mangled + 1) != 'g')
+                    return nullptr;
+
+                // wild
+                *Demangled << " inout";
+                Mangled += 2;
+                continue;
+
+            default:
+                return Mangled;
+        }
+    }
+
+    return nullptr;
+}
+
+const char *Demangler::parseCallConvention(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    if (Mangled == nullptr || Mangled == End)
+        return nullptr;
+
+    switch (*Mangled)
+    {
+        case 'F': // (D)
+            break;
+
+        case 'U': // (C)
+            *Demangled << "extern(C) ";
+            break;
+
+        case 'W': // (Windows)
+            *Demangled << "extern(Windows) ";
+            break;
+
+        case 'V': // (Pascal)
+            *Demangled << "extern(Pascal) ";
+            break;
+
+        case 'R': // (C++)
+            *Demangled << "extern(C++) ";
+            break;
+
+        case 'Y': // (Objective-C)
+            *Demangled << "extern(Objective-C) ";
+            break;
+
+        default:
+            return nullptr;
+    }
+
+    return Mangled + 1;
+}
+
+const char *Demangler::parseAttributes(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    if (Mangled == nullptr)
+        return nullptr;
+
+    while (Mangled != End && *Mangled == 'N')
+    {
+        StringView Attribute;
+        switch (peek(Mangled + 1))
+        {
+            case 'a':
+                Attribute = "pure ";
+                break;
+
+            case 'b':
+                Attribute = "nothrow ";
+                break;
+
+            case 'c':
+                Attribute = "ref ";
+                break;
+
+            case 'd':
+                Attribute = "@property ";
+                break;
+
+            case 'e':
+                Attribute = "@trusted ";
+                break;
+
+            case 'f':
+                Attribute = "@safe ";
+                break;
+
+            case 'g':
+            case 'h':
+            case 'k':
+            case 'n':
+                // inout parameter is represented as 'Ng'.
+                // vector parameter is represented as 'Nh'.
+                // return parameter is represented as 'Nk'.
+                // typeof(*null) parameter is represented as 'Nn'.
+                // If we see this, then we know we're really in the
+                // parameter list.
+                return Mangled;
+
+            case 'i':
+                Attribute = "@nogc ";
+                break;
+
+            case 'j':
+                Attribute = "return ";
+                break;
+
+            case 'l':
+                Attribute = "scope ";
+                break;
+
+            case 'm':
+                Attribute = "@live ";
+                break;
+
+            default: // unknown attribute
+                return nullptr;
+        }
+
+        *Demangled << Attribute;
+        Mangled += 2;
+    }
+
+    return Mangled;
+}
+
+const char *Demangler::parseFunctionArgs(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    size_t N = 0;
+
+    while (Mangled != nullptr && Mangled != End)
+    {
+        switch (*Mangled)
+        {
+            case 'X': // (variadic T t...) style.
+                *Demangled << "...";
+                return Mangled + 1;
+
+            case 'Y': // (variadic T t, ...) style.
+                if (N != 0)
+                    *Demangled << ", ";
+                *Demangled << "...";
+                return Mangled + 1;
+
+            case 'Z': // Normal function.
+                return Mangled + 1;
+        }
+
+        if (N++)
+            *Demangled << ", ";
+
+        if (*Mangled == 'M') // scope(T)
+        {
+            ++Mangled;
+            *Demangled << "scope ";
+        }
+
+        if (StringView(Mangled, End).startsWith("Nk")) // return(T)
+        {
+            Mangled += 2;
+            *Demangled << "return ";
+        }
+
+        switch (peek(Mangled))
+        {
+            case 'I': // in(T)
+                ++Mangled;
+                *Demangled << "in ";
+                if (peek(Mangled) == 'K') // in ref(T)
+                {
+                    ++Mangled;
+                    *Demangled << "ref ";
+                }
+                break;
+
+            case 'J': // out(T)
+                ++Mangled;
+                *Demangled << "out ";
+                break;
+
+            case 'K': // ref(T)
+                ++Mangled;
+                *Demangled << "ref ";
+                break;
+
+            case 'L': // lazy(T)
+                ++Mangled;
+                *Demangled << "lazy ";
+                break;
+        }
+
+        Mangled = parseType(Demangled, Mangled);
+    }
+
+    return nullptr;
+}
+
+const char *Demangler::parseFunctionType(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    // The order of the mangled string is:
+    //    CallConvention FuncAttrs Arguments ArgClose Type
+    // The demangled string is re-ordered as:
+    //    CallConvention Type Arguments FuncAttrs
+    // so the attributes and arguments are skipped over to get to the return
+    // type first.
+    Mangled = parseCallConvention(Demangled, Mangled);
+
+    const char *Attributes = Mangled;
+    Mangled = parseAttributes(&Discard, Mangled);
+
+    const char *Arguments = Mangled;
+    Mangled = parseFunctionArgs(&Discard, Mangled);
+
+    // Function return type.
+    Mangled = parseType(Demangled, Mangled);
+    if (Mangled == nullptr || discards(Demangled))
+        return Mangled;
+
+    *Demangled << '(';
+    parseFunctionArgs(Demangled, Arguments);
+    *Demangled << ") ";
+    parseAttributes(Demangled, Attributes);
+
+    return Mangled;
+}
+
+const char *Demangler::parseTuple(OutputBuffer *Demangled, const char *Mangled)
+{
+    //    TypeTuple:
+    //        B Number Parameters
+    //          ^
+    unsigned long Elements;
+
+    Mangled = decodeNumber(Mangled, Elements);
+    if (Mangled == nullptr)
+        return nullptr;
+
+    *Demangled << "Tuple!(";
+
+    while (Elements--)
+    {
+        Mangled = parseType(Demangled, Mangled);
+        if (Mangled == nullptr)
+            return nullptr;
+
+        if (Elements != 0)
+            *Demangled << ", ";
+    }
+
+    *Demangled << ')';
+    return Mangled;
+}
+
+const char *Demangler::parseTemplate(OutputBuffer *Demangled,
+    const char *Mangled, unsigned long Len)
+{
+    // Template instance names have the types and values of its parameters
+    // encoded into it.
+    //    TemplateInstanceName:
+    //        Number __T LName TemplateArgs Z
+    //        Number __U LName TemplateArgs Z
+    //               ^
+    // The start pointer should be at the above location, and Len should be
+    // the value of the decoded number.
+    const char *Start = Mangled;
+    Mangled += 3;
+
+    // Template symbol.
+    if (!isSymbolName(Mangled) || *Mangled == '0')
+        return nullptr;
+
+    // Template identifier.
+    Mangled = parseIdentifier(Demangled, Mangled);
+
+    // Template arguments.
+    *Demangled << "!(";
+    Mangled = parseTemplateArgs(Demangled, Mangled);
+    *Demangled << ')';
+
+    // Check for template name length mismatch.
+    if (Len != TemplateLengthUnknown && Mangled != nullptr
+        && static_cast<unsigned long>(Mangled - Start) != Len)
+        return nullptr;
+
+    return Mangled;
+}
+
+const char *Demangler::parseTemplateArgs(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    size_t N = 0;
+
+    while (Mangled != nullptr && Mangled != End)
+    {
+        // End of parameter list.
+        if (*Mangled == 'Z')
+            return Mangled + 1;
+
+        if (N++)
+            *Demangled << ", ";
+
+        // Skip over specialised template prefix.
+        if (*Mangled == 'H')
+            ++Mangled;
+
+        switch (peek(Mangled))
+        {
+            case 'S': // Symbol parameter.
+                Mangled = parseTemplateSymbolParam(Demangled, Mangled + 1);
+                break;
+
+            case 'T': // Type parameter.
+                Mangled = parseType(Demangled, Mangled + 1);
+                break;
+
+            case 'V': // Value parameter.
+            {
+                // Peek at the type.
+                const char *Name = ++Mangled;
+                char Type = peek(Mangled);
+                if (Type == 'Q')
+                {
+                    // Value type is a back reference, peek at the real type.
+                    const char *Backref;
+                    if (decodeBackref(Mangled, Backref) == nullptr)
+                        return nullptr;
+                    Type = *Backref;
+                }
+
+                // The type is only printed for struct literals, by
+                // parseStructLiteral().
+                Mangled = parseType(&Discard, Mangled);
+                Mangled = parseValue(Demangled, Mangled, Name, Type);
+                break;
+            }
+
+            case 'X': // Externally mangled parameter.
+            {
+                unsigned long Len;
+                const char *Endptr = decodeNumber(Mangled + 1, Len);
+                if (Endptr == nullptr || static_cast<size_t>(End - Endptr) < Len)
+                    return nullptr;
+
+                *Demangled << StringView(Endptr, Len);
+                Mangled = Endptr + Len;
+                break;
+            }
+
+            default:
+                return nullptr;
+        }
+    }
+
+    return nullptr;
+}
+
+const char *Demangler::parseTemplateSymbolParam(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    if (StringView(Mangled, End).startsWith("_D") && isSymbolName(Mangled + 2))
+        return parseMangle(Demangled, Mangled);
+
+    if (peek(Mangled) == 'Q')
+        return parseQualified(Demangled, Mangled, /*SuffixModifiers=*/false);
+
+    unsigned long Len;
+    const char *Endptr = decodeNumber(Mangled, Len);
+
+    if (Endptr == nullptr || Len == 0)
+        return nullptr;
+
+    // In template parameter symbols generated by the frontend up to 2.076,
+    // the symbol length is encoded and the first character of the mangled
+    // name can be a digit. This causes ambiguity issues because the digits
+    // of the two numbers are adjacent, so work backwards until a match is
+    // found. When the length runs out, the whole symbol is tried, whatever
+    // length it turns out to have.
+    SymbolParam &Memo = SymbolParams[(Mangled - Str) % SymbolParamCacheSize];
+    if (Memo.Start != Mangled || Memo.LastBackref != LastBackref)
+    {
+        const char *Symbol = nullptr;
+        const char *Rest = nullptr;
+        const char *Candidate = Endptr;
+        for (unsigned long Size = Len;; Size /= 10, --Candidate)
+        {
+            if (++SymbolParamTrials > MaxSymbolParamTrials)
+                return nullptr;
+
+            Rest = parseSymbolParamCandidate(&Discard, Candidate);
+
+            // Check for name length mismatch.
+            if (Rest != nullptr
+                && (Size == 0 || static_cast<unsigned long>(Rest - Candidate) == Size))
+            {
+                Symbol = Candidate;
+                break;
+            }
+
+            // No match on any combinations.
+            if (Size == 0)
+                break;
+        }
+
+        Memo.Start = Mangled;
+        Memo.LastBackref = LastBackref;
+        Memo.Symbol = Symbol;
+        Memo.Rest = Rest;
+    }
+
+    if (Memo.Symbol == nullptr)
+        return nullptr;
+
+    const char *Rest = Memo.Rest;
+    if (!discards(Demangled))
+        parseSymbolParamCandidate(Demangled, Memo.Symbol);
+    return Rest;
+}
+
+const char *Demangler::parseSymbolParamCandidate(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    // Check whether template parameter is a function with a valid return type
+    // or an untyped identifier.
+    if (isSymbolName(Mangled))
+        return parseQualified(Demangled, Mangled, /*SuffixModifiers=*/false);
+
+    if (StringView(Mangled, End).startsWith("_D") && isSymbolName(Mangled + 2))
+        return parseMangle(Demangled, Mangled);
+
+    return nullptr;
+}
+
+const char *Demangler::parseValue(OutputBuffer *Demangled, const char *Mangled,
+    const char *Name, char Type)
+{
+    if (Mangled == nullptr || Mangled == End
+        || RecursionLevel >= MaxRecursionLevel)
+        return nullptr;
+
+    ScopedOverride<size_t> SaveRecursionLevel(RecursionLevel,
+        RecursionLevel + 1);
+
+    switch (*Mangled)
+    {
+        // Null value.
+        case 'n':
+            *Demangled << "null";
+            return Mangled + 1;
+
+        // Integral values.
+        case 'N':
+            *Demangled << '-';
+            return parseInteger(Demangled, Mangled + 1, Type);
+
+        case 'i':
+            return parseInteger(Demangled, Mangled + 1, Type);
+
+        // There really should always be an `i' before encoded numbers, but
+        // there wasn't in early versions of D2, so this case range must remain
+        // for backwards compatibility.
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            return parseInteger(Demangled, Mangled, Type);
+
+        // Real value.
+        case 'e':
+            return parseReal(Demangled, Mangled + 1);
+
+        // Complex value.
+        case 'c':
+            Mangled = parseReal(Demangled, Mangled + 1);
+            *Demangled << '+';
+            if (Mangled == nullptr || peek(Mangled) != 'c')
+                return nullptr;
+            Mangled = parseReal(Demangled, Mangled + 1);
+            *Demangled << 'i';
+            return Mangled;
+
+        // String values.
+        case 'a': // UTF8
+        case 'w': // UTF16
+        case 'd': // UTF32
+            return parseString(Demangled, Mangled);
+
+        // Array values.
+        case 'A':
+            if (Type == 'H')
+                return parseAssocArray(Demangled, Mangled + 1);
+            return parseArrayLiteral(Demangled, Mangled + 1);
+
+        // Struct values.
+        case 'S':
+            return parseStructLiteral(Demangled, Mangled + 1, Name);
+
+        // Function literal symbol.
+        case 'f':
+            ++Mangled;
+            if (!StringView(Mangled, End).startsWith("_D")
+                || !isSymbolName(Mangled + 2))
+                return nullptr;
+            return parseMangle(Demangled, Mangled);
+
+        default:
+            return nullptr;
+    }
+}
+
+const char *Demangler::parseInteger(OutputBuffer *Demangled,
+    const char *Mangled, char Type)
+{
+    if (Type == 'a' || Type == 'u' || Type == 'w')
+    {
+        // Parse character value.
+        unsigned long Val;
+        Mangled = decodeNumber(Mangled, Val);
+        if (Mangled == nullptr)
+            return nullptr;
+
+        *Demangled << '\'';
+        if (Type == 'a' && Val >= 0x20 && Val < 0x7F)
+        {
+            // Represent as a character literal.
+            *Demangled << static_cast<char>(Val);
+        }
+        else
+        {
+            // Represent as a hexadecimal value.
+            int Width;
+            switch (Type)
+            {
+                case 'a': // char
+                    *Demangled << "\\x";
+                    Width = 2;
+                    break;
+
+                case 'u': // wchar
+                    *Demangled << "\\u";
+                    Width = 4;
+                    break;
+
+                default: // dchar
+                    *Demangled << "\\U";
+                    Width = 8;
+                    break;
+            }
+
+            // Val is at most UINT_MAX.
+            char Digits[8];
+            size_t Pos = sizeof(Digits);
+            for (; Val != 0; Val /= 16, --Width)
+                Digits[--Pos] = "0123456789abcdef"[Val % 16];
+            for (; Width > 0; --Width)
+                Digits[--Pos] = '0';
+            *Demangled << StringView(Digits + Pos, Digits + sizeof(Digits));
+        }
+        *Demangled << '\'';
+
+        return Mangled;
+    }
+
+    if (Type == 'b')
+    {
+        // Parse boolean value.
+        unsigned long Val;
+        Mangled = decodeNumber(Mangled, Val);
+        if (Mangled == nullptr)
+            return nullptr;
+
+        *Demangled << (Val ? "true" : "false");
+        return Mangled;
+    }
+
+    // Parse integer value.
+    const char *Digits = Mangled;
+    while (Mangled != End && std::isdigit(*Mangled))
+        ++Mangled;
+
+    if (Mangled == Digits)
+        return nullptr;
+
+    *Demangled << StringView(Digits, Mangled);
+
+    // Append suffix.
+    switch (Type)
+    {
+        case 'h': // ubyte
+        case 't': // ushort
+        case 'k': // uint
+            *Demangled << 'u';
+            break;
+
+        case 'l': // long
+            *Demangled << 'L';
+            break;
+
+        case 'm': // ulong
+            *Demangled << "uL";
+            break;
+    }
+
+    return Mangled;
+}
+
+const char *Demangler::parseReal(OutputBuffer *Demangled, const char *Mangled)
+{
+    // Handle NAN and +-INF.
+    StringView Value(Mangled, End);
+    if (Value.startsWith("NAN"))
+    {
+        *Demangled << "NaN";
+        return Mangled + 3;
+    }
+    if (Value.startsWith("INF"))
+    {
+        *Demangled << "Inf";
+        return Mangled + 3;
+    }
+    if (Value.startsWith("NINF"))
+    {
+        *Demangled << "-Inf";
+        return Mangled + 4;
+    }
+
+    // Hexadecimal prefix and leading bit.
+    if (peek(Mangled) == 'N')
+    {
+        *Demangled << '-';
+        ++Mangled;
+    }
+
+    if (!std::isxdigit(peek(Mangled)))
+        return nullptr;
+
+    *Demangled << "0x" << *Mangled << '.';
+    ++Mangled;
+
+    // Significand.
+    const char *Significand = Mangled;
+    while (Mangled != End && std::isxdigit(*Mangled))
+        ++Mangled;
+    *Demangled << StringView(Significand, Mangled);
+
+    // Exponent.
+    if (peek(Mangled) != 'P')
+        return nullptr;
+
+    *Demangled << 'p';
+    ++Mangled;
+
+    if (peek(Mangled) == 'N')
+    {
+        *Demangled << '-';
+        ++Mangled;
+    }
+
+    const char *Exponent = Mangled;
+    while (Mangled != End && std::isdigit(*Mangled))
+        ++Mangled;
+    *Demangled << StringView(Exponent, Mangled);
+
+    return Mangled;
+}
+
+const char *Demangler::parseString(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    //    CharWidth Number _ HexDigits
+    //    ^
+    char Type = *Mangled;
+    unsigned long Len;
+
+    Mangled = decodeNumber(Mangled + 1, Len);
+    if (Mangled == nullptr || *Mangled != '_')
+        return nullptr;
+
+    ++Mangled;
+    *Demangled << '"';
+
+    while (Len--)
+    {
+        char Val;
+        const char *Endptr = decodeHexDigit(Mangled, Val);
+        if (Endptr == nullptr)
+            return nullptr;
+
+        // Sanitize white and non-printable characters.
+        switch (Val)
+        {
+            case ' ':
+                *Demangled << ' ';
+                break;
+
+            case '\t':
+                *Demangled << "\\t";
+                break;
+
+            case '\n':
+                *Demangled << "\\n";
+                break;
+
+            case '\r':
+                *Demangled << "\\r";
+                break;
+
+            case '\f':
+                *Demangled << "\\f";
+                break;
+
+            case '\v':
+                *Demangled << "\\v";
+                break;
+
+            default:
+                if (std::isprint(static_cast<unsigned char>(Val)))
+                    *Demangled << Val;
+                else
+                    *Demangled << "\\x" << StringView(Mangled, 2);
+        }
+
+        Mangled = Endptr;
+    }
+
+    *Demangled << '"';
+    if (Type != 'a')
+        *Demangled << Type;
+
+    return Mangled;
+}
+
+const char *Demangler::parseArrayLiteral(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    unsigned long Elements;
+
+    Mangled = decodeNumber(Mangled, Elements);
+    if (Mangled == nullptr)
+        return nullptr;
+
+    *Demangled << '[';
+
+    while (Elements--)
+    {
+        Mangled = parseValue(Demangled, Mangled, nullptr, '\0');
+        if (Mangled == nullptr)
+            return nullptr;
+
+        if (Elements != 0)
+            *Demangled << ", ";
+    }
+
+    *Demangled << ']';
+    return Mangled;
+}
+
+const char *Demangler::parseAssocArray(OutputBuffer *Demangled,
+    const char *Mangled)
+{
+    unsigned long Elements;
+
+    Mangled = decodeNumber(Mangled, Elements);
+    if (Mangled == nullptr)
+        return nullptr;
+
+    *Demangled << '[';
+
+    while (Elements--)
+    {
+        Mangled = parseValue(Demangled, Mangled, nullptr, '\0');
+        if (Mangled == nullptr)
+            return nullptr;
+
+        *Demangled << ':';
+
+        Mangled = parseValue(Demangled, Mangled, nullptr, '\0');
+        if (Mangled == nullptr)
+            return nullptr;
+
+        if (Elements != 0)
+            *Demangled << ", ";
+    }
+
+    *Demangled << ']';
+    return Mangled;
+}
+
+const char *Demangler::parseStructLiteral(OutputBuffer *Demangled,
+    const char *Mangled, const char *Name)
+{
+    unsigned long Args;
+
+    Mangled = decodeNumber(Mangled, Args);
+    if (Mangled == nullptr)
+        return nullptr;
+
+    if (Name != nullptr && !discards(Demangled))
+        parseType(Demangled, Name);
+
+    *Demangled << '(';
+
+    while (Args--)
+    {
+        Mangled = parseValue(Demangled, Mangled, nullptr, '\0');
+        if (Mangled == nullptr)
+            return nullptr;
+
+        if (Args != 0)
+            *Demangled << ", ";
+    }
+
+    *Demangled << ')';
+    return Mangled;
+}
+
+const char *Demangler::parseLName(OutputBuffer *Demangled, const char *Mangled,
+    unsigned long Len)
+{
+    switch (Len)
+    {
+        case 6:
+            if (StringView(Mangled, Len) == "__ctor")
+            {
+                // Constructor symbol for a class/struct.
+                *Demangled << "this";
+                Mangled += Len;
+                return Mangled;
+            }
+            if (StringView(Mangled, Len) == "__dtor")
+            {
+                // Destructor symbol for a class/struct.
+                *Demangled << "~this";
+                Mangled += Len;
+                return Mangled;
+            }
+            if (StringView(Mangled, End).startsWith("__initZ"))
+            {
+                // The static initializer for a given symbol.
+                Demangled->prepend("initializer for ");
+                Demangled->setCurrentPosition(Demangled->getCurrentPosition() - 1);
+                Mangled += Len;
+                return Mangled;
+            }
+            if (StringView(Mangled, End).startsWith("__vtblZ"))
+            {
+                // The vtable symbol for a given class.
+                Demangled->prepend("vtable for ");
+                Demangled->setCurrentPosition(Demangled->getCurrentPosition() - 1);
+                Mangled += Len;
+                return Mangled;
+            }
+            break;
 
         case 7:
-            if (strncmp(Mangled, "__ClassZ", Len + 1) == 0)
+            if (StringView(Mangled, End).startsWith("__ClassZ"))
             {
                 // The classinfo symbol for a given class.
                 Demangled->prepend("ClassInfo for ");
@@ -536,8 +2018,18 @@ const char *Demangler::parseLName(OutputBuffer *Demangled, const char *Mangled,
             }
             break;
 
+        case 10:
+            if (StringView(Mangled, End).startsWith("__postblitMFZ"))
+            {
+                // Postblit symbol for a struct.
+                *Demangled << "this(this)";
+                Mangled += Len + 3;
+                return Mangled;
+            }
+            break;
+
         case 11:
-            if (strncmp(Mangled, "__InterfaceZ", Len + 1) == 0)
+            if (StringView(Mangled, End).startsWith("__InterfaceZ"))
             {
                 // The interface symbol for a given class.
                 Demangled->prepend("Interface for ");
@@ -548,7 +2040,7 @@ const char *Demangler::parseLName(OutputBuffer *Demangled, const char *Mangled,
             break;
 
         case 12:
-            if (strncmp(Mangled, "__ModuleInfoZ", Len + 1) == 0)
+            if (StringView(Mangled, End).startsWith("__ModuleInfoZ"))
             {
                 // The ModuleInfo symbol for a given module.
                 Demangled->prepend("ModuleInfo for ");
@@ -565,35 +2057,55 @@ const char *Demangler::parseLName(OutputBuffer *Demangled, const char *Mangled,
     return Mangled;
 }
 
-Demangler::Demangler(const char *Mangled) :
-    Str(Mangled), LastBackref(strlen(Mangled)) { }
+Demangler::Demangler(const char *Mangled, size_t Length) :
+    Str(Mangled), End(Mangled + Length), LastBackref(Length),
+    Discard(nullptr, 0, /*FixedSize=*/true) { }
 
 const char *Demangler::parseMangle(OutputBuffer *Demangled)
 {
-    return parseMangle(Demangled, this->Str);
+    const char *Mangled = parseMangle(Demangled, this->Str);
+    if (SymbolParamTrials > MaxSymbolParamTrials)
+        return nullptr;
+    return Mangled;
+}
+
+// Demangles MangledName, which starts with "_D", into Demangled. Returns false
+// if it isn't a valid D symbol.
+static bool demangleDLang(StringView MangledName, OutputBuffer &Demangled)
+{
+    if (MangledName == "_Dmain")
+    {
+        Demangled << "D main";
+        return true;
+    }
+
+    Demangler D(MangledName.begin(), MangledName.size());
+    const char *Rest = D.parseMangle(&Demangled);
+
+    // Check that the entire symbol was successfully demangled.
+    return Rest == MangledName.end();
 }
 
 char *llvm::dlangDemangle(const char *MangledName)
 {
-    if (MangledName == nullptr || strncmp(MangledName, "_D", 2) != 0)
+    if (MangledName == nullptr)
+        return nullptr;
+    return dlangDemangle(MangledName, std::strlen(MangledName));
+}
+
+char *llvm::dlangDemangle(const char *MangledName, size_t Length)
+{
+    if (MangledName == nullptr)
+        return nullptr;
+    StringView Mangled(MangledName, Length);
+    if (!Mangled.startsWith("_D"))
         return nullptr;
 
     OutputBuffer Demangled;
-    if (strcmp(MangledName, "_Dmain") == 0)
-    {
-        Demangled << "D main";
-    }
-    else
+    if (!demangleDLang(Mangled, Demangled))
     {
-        Demangler D = Demangler(MangledName);
-        MangledName = D.parseMangle(&Demangled);
-
-        // Check that the entire symbol was successfully demangled.
-        if (MangledName == nullptr || *MangledName != '\0')
-        {
-            std::free(Demangled.getBuffer());
-            return nullptr;
-        }
+        std::free(Demangled.getBuffer());
+        return nullptr;
     }
 
     // OutputBuffer's internal buffer is not null terminated and therefore we need
@@ -608,3 +2120,34 @@ char *llvm::dlangDemangle(const char *MangledName)
     std::free(Demangled.getBuffer());
     return nullptr;
 }
+
+int llvm::dlangDemangleNoHeap(const char *MangledName, char *Buf,
+    size_t BufSize)
+{
+    return dlangDemangleNoHeap(MangledName,
+        MangledName != nullptr ? std::strlen(MangledName) : 0, Buf, BufSize);
+}
+
+int llvm::dlangDemangleNoHeap(const char *MangledName, size_t Length,
+    char *Buf, size_t BufSize)
+{
+    if (MangledName == nullptr || Buf == nullptr || BufSize == 0)
+        return demangle_invalid_args;
+    *Buf = '\0';
+
+    StringView Mangled(MangledName, Length);
+    if (!Mangled.startsWith("_D"))
+        return demangle_invalid_mangled_name;
+
+    // Keep the last byte for the terminator.
+    OutputBuffer Demangled(Buf, BufSize - 1, /*FixedSize=*/true);
+    if (!demangleDLang(Mangled, Demangled) ||
+        (Demangled.getCurrentPosition() == 0 && !Demangled.isTruncated()))
+    {
+        *Buf = '\0';
+        return demangle_invalid_mangled_name;
+    }
+
+    Demangled.getBuffer()[Demangled.getCurrentPosition()] = '\0';
+    return Demangled.isTruncated() ? demangle_truncated : demangle_success;
+}
@@ -11,56 +11,566 @@
 //===----------------------------------------------------------------------===//
 
 #include <demangler/Demangle.h>
+#include <demangler/StringView.h>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <utility>
 
-static bool isItaniumEncoding(const char *S)
+using llvm::DemangleScheme;
+using llvm::itanium_demangle::StringView;
+
+static bool isItaniumEncoding(StringView S)
 {
     // Itanium encoding requires 1 or 3 leading underscores, followed by 'Z'.
-    return std::strncmp(S, "_Z", 2) == 0 || std::strncmp(S, "___Z", 4) == 0;
+    return S.startsWith("_Z") || S.startsWith("___Z");
+}
+
+static bool isRustEncoding(StringView S)
+{
+    return S.startsWith("_R");
+}
+
+static bool isDLangEncoding(StringView S)
+{
+    return S.startsWith("_D");
+}
+
+static bool isMicrosoftEncoding(StringView S)
+{
+    // Typeinfo names start with a '.', all symbols with a '?'.
+    return S.startsWith('?') || S.startsWith('.');
+}
+
+static DemangleScheme nonMicrosoftScheme(StringView S)
+{
+    if (isItaniumEncoding(S))
+        return DemangleScheme::Itanium;
+    if (isRustEncoding(S))
+        return DemangleScheme::Rust;
+    if (isDLangEncoding(S))
+        return DemangleScheme::DLang;
+    return DemangleScheme::Unknown;
+}
+
+static bool hasSchemePrefix(StringView S, DemangleScheme Scheme)
+{
+    switch (Scheme)
+    {
+        case DemangleScheme::Itanium:
+            return isItaniumEncoding(S);
+        case DemangleScheme::Rust:
+            return isRustEncoding(S) || isItaniumEncoding(S);
+        case DemangleScheme::DLang:
+            return isDLangEncoding(S);
+        case DemangleScheme::Microsoft:
+            return isMicrosoftEncoding(S);
+        case DemangleScheme::Unknown:
+            break;
+    }
+    return false;
+}
+
+// Returns a malloc()ed demangled name, or nullptr if MangledName isn't a
+// valid Scheme symbol.
+static char *demangleScheme(StringView MangledName, DemangleScheme Scheme)
+{
+    const char *Name = MangledName.begin();
+    size_t Length = MangledName.size();
+    switch (Scheme)
+    {
+        case DemangleScheme::Itanium:
+            // Legacy Rust symbols are Itanium names too.
+            if (char *Demangled = llvm::rustDemangle(Name, Length))
+                return Demangled;
+            return llvm::itaniumDemangle(Name, Length, nullptr, nullptr,
+                nullptr);
+        case DemangleScheme::Rust:
+            return llvm::rustDemangle(Name, Length);
+        case DemangleScheme::DLang:
+            return llvm::dlangDemangle(Name, Length);
+        case DemangleScheme::Microsoft:
+            return llvm::microsoftDemangle(Name, Length, nullptr, nullptr,
+                nullptr, nullptr);
+        case DemangleScheme::Unknown:
+            break;
+    }
+    return nullptr;
 }
 
-static bool isRustEncoding(const char *S)
+// Heap-free version of demangleScheme(), which returns what the NoHeap
+// demanglers do.
+static int demangleSchemeNoHeap(StringView MangledName, DemangleScheme Scheme,
+    char *Buf, size_t BufSize, void *Scratch, size_t ScratchSize)
 {
-    return S[0] == '_' && S[1] == 'R';
+    const char *Name = MangledName.begin();
+    size_t Length = MangledName.size();
+    switch (Scheme)
+    {
+        case DemangleScheme::Itanium:
+        {
+            int Status = llvm::rustDemangleNoHeap(Name, Length, Buf, BufSize);
+            if (Status != llvm::demangle_invalid_mangled_name)
+                return Status;
+            return llvm::itaniumDemangleNoHeap(Name, Length, Buf, BufSize,
+                Scratch, ScratchSize);
+        }
+        case DemangleScheme::Rust:
+            return llvm::rustDemangleNoHeap(Name, Length, Buf, BufSize);
+        case DemangleScheme::DLang:
+            return llvm::dlangDemangleNoHeap(Name, Length, Buf, BufSize);
+        case DemangleScheme::Microsoft:
+            return llvm::microsoftDemangleNoHeap(Name, Length, Buf, BufSize,
+                Scratch, ScratchSize);
+        case DemangleScheme::Unknown:
+            break;
+    }
+    return llvm::demangle_invalid_mangled_name;
 }
 
-static bool isDLangEncoding(const std::string &MangledName)
+// Returns a malloc()ed demangled name, or nullptr if MangledName isn't an
+// Itanium, Rust or D symbol.
+static char *nonMicrosoftDemangle(StringView MangledName)
 {
-    return MangledName.size() >= 2 && MangledName[0] == '_' && MangledName[1] == 'D';
+    return demangleScheme(MangledName, nonMicrosoftScheme(MangledName));
+}
+
+// The scheme detection of demangle(). Returns a malloc()ed demangled name, or
+// nullptr if no scheme applies.
+static char *demangleWithAnyScheme(StringView S)
+{
+    if (char *Demangled = nonMicrosoftDemangle(S))
+        return Demangled;
+
+    if (S.startsWith('_'))
+        if (char *Demangled = nonMicrosoftDemangle(S.dropFront(1)))
+            return Demangled;
+
+    return demangleScheme(S, DemangleScheme::Microsoft);
+}
+
+// Heap-free version of demangleWithAnyScheme(). Buf is left empty if no
+// scheme applies.
+static int demangleWithAnySchemeNoHeap(StringView S, char *Buf,
+    size_t BufSize, void *Scratch, size_t ScratchSize)
+{
+    int Status = demangleSchemeNoHeap(S, nonMicrosoftScheme(S), Buf, BufSize,
+        Scratch, ScratchSize);
+    if (Status == llvm::demangle_invalid_mangled_name && S.startsWith('_'))
+    {
+        StringView Rest = S.dropFront(1);
+        Status = demangleSchemeNoHeap(Rest, nonMicrosoftScheme(Rest), Buf,
+            BufSize, Scratch, ScratchSize);
+    }
+    if (Status == llvm::demangle_invalid_mangled_name)
+        Status = demangleSchemeNoHeap(S, DemangleScheme::Microsoft, Buf,
+            BufSize, Scratch, ScratchSize);
+    return Status;
+}
+
+// Fills in the Inline buffer and Size of a DemangledName for MangledName,
+// returning its Heap. NoHeap(Buf, BufSize, Scratch, ScratchSize) is tried
+// first, which covers names that fit inline; Heap() only if the name was
+// demangled but didn't fit in Inline or Scratch. Names neither demangles are
+// copied as they are.
+template<typename NoHeapFn, typename HeapFn>
+static char *fillDemangledName(StringView MangledName, char *Inline,
+    size_t &Size, NoHeapFn NoHeap, HeapFn Heap)
+{
+    constexpr size_t InlineSize = llvm::DemangledName::InlineSize;
+    alignas(std::max_align_t) char Scratch[8192];
+    int Status = NoHeap(Inline, InlineSize, Scratch, sizeof(Scratch));
+    if (Status == llvm::demangle_success)
+    {
+        Size = std::strlen(Inline);
+        return nullptr;
+    }
+
+    // Only running out of room is worth parsing the name again for; any
+    // other failure would just repeat itself on the heap.
+    char *Demangled = nullptr;
+    if (Status == llvm::demangle_truncated ||
+        Status == llvm::demangle_memory_alloc_failure)
+        Demangled = Heap();
+
+    size_t Length = MangledName.size();
+    if (Demangled == nullptr && Length < InlineSize)
+    {
+        std::memcpy(Inline, MangledName.begin(), Length);
+        Inline[Length] = '\0';
+        Size = Length;
+        return nullptr;
+    }
+
+    if (Demangled == nullptr)
+    {
+        Demangled = static_cast<char *>(std::malloc(Length + 1));
+        if (Demangled == nullptr)
+            std::terminate();
+        std::memcpy(Demangled, MangledName.begin(), Length);
+        Demangled[Length] = '\0';
+        Size = Length;
+        return Demangled;
+    }
+    Size = std::strlen(Demangled);
+    return Demangled;
 }
 
 std::string llvm::demangle(const std::string &MangledName)
 {
-    std::string Result;
-    const char *S = MangledName.c_str();
+    char *Demangled = demangleWithAnyScheme(
+        StringView(MangledName.data(), MangledName.size()));
+    if (Demangled == nullptr)
+        return MangledName;
 
-    if (nonMicrosoftDemangle(S, Result))
-        return Result;
+    std::string Result = Demangled;
+    std::free(Demangled);
+    return Result;
+}
 
-    if (S[0] == '_' && nonMicrosoftDemangle(S + 1, Result))
+llvm::DemangledName llvm::demangle(const char *MangledName, size_t Length)
+{
+    DemangledName Result;
+    if (MangledName == nullptr)
         return Result;
 
-    if (char *Demangled = microsoftDemangle(S, nullptr, nullptr, nullptr, nullptr))
+    StringView Mangled(MangledName, Length);
+    Result.Heap = fillDemangledName(Mangled, Result.Inline, Result.Size,
+        [Mangled](char *Buf, size_t BufSize, void *Scratch, size_t ScratchSize) {
+            return demangleWithAnySchemeNoHeap(Mangled, Buf, BufSize, Scratch,
+                ScratchSize);
+        },
+        [Mangled]() { return demangleWithAnyScheme(Mangled); });
+    return Result;
+}
+
+llvm::DemangleScheme llvm::classify(const char *MangledName,
+    DemangleFlags Flags)
+{
+    if (MangledName == nullptr)
+        return DemangleScheme::Unknown;
+    return classify(MangledName, std::strlen(MangledName), Flags);
+}
+
+// The same choices as demangleWithAnyScheme(), except that Flags may rule
+// some out.
+llvm::DemangleScheme llvm::classify(const char *MangledName, size_t Length,
+    DemangleFlags Flags)
+{
+    if (MangledName == nullptr)
+        return DemangleScheme::Unknown;
+
+    StringView S(MangledName, Length);
+    DemangleScheme Scheme;
+    if (Flags & DF_StripUnderscore)
+    {
+        if (!S.consumeFront('_'))
+            return DemangleScheme::Unknown;
+        Scheme = nonMicrosoftScheme(S);
+    }
+    else
     {
-        Result = Demangled;
-        std::free(Demangled);
+        Scheme = nonMicrosoftScheme(S);
+        if (Scheme == DemangleScheme::Unknown && S.startsWith('_'))
+            Scheme = nonMicrosoftScheme(S.dropFront(1));
+    }
+
+    if (Scheme == DemangleScheme::Unknown && !(Flags & DF_NoMicrosoft)
+        && isMicrosoftEncoding(S))
+        Scheme = DemangleScheme::Microsoft;
+    return Scheme;
+}
+
+// A little-endian word of the four bytes of Name from Offset on, padded with
+// zeros. No prefix classify() looks for has a zero byte, so the padding never
+// matches one.
+static uint32_t loadPrefix(const char *Name, size_t Length, size_t Offset)
+{
+    uint32_t Word = 0;
+    for (size_t I = 0; I < 4 && Offset + I < Length; ++I)
+        Word |= uint32_t(uint8_t(Name[Offset + I])) << (8 * I);
+    return Word;
+}
+
+static constexpr uint32_t prefixWord(char A, char B, char C = 0, char D = 0)
+{
+    return uint32_t(uint8_t(A)) | uint32_t(uint8_t(B)) << 8
+        | uint32_t(uint8_t(C)) << 16 | uint32_t(uint8_t(D)) << 24;
+}
+
+// nonMicrosoftScheme() on a word from loadPrefix().
+static uint32_t nonMicrosoftScheme(uint32_t Word)
+{
+    uint32_t Two = Word & 0xFFFF;
+    uint32_t Itanium = (Two == prefixWord('_', 'Z'))
+        | (Word == prefixWord('_', '_', '_', 'Z'));
+    uint32_t Rust = Two == prefixWord('_', 'R');
+    uint32_t DLang = Two == prefixWord('_', 'D');
+    return Itanium * uint32_t(DemangleScheme::Itanium)
+        + Rust * uint32_t(DemangleScheme::Rust)
+        + DLang * uint32_t(DemangleScheme::DLang);
+}
+
+// classify() on N names from the words loadPrefix() gives for their first
+// bytes (Heads) and for those after the first (Nexts), with Strip and
+// Microsoft standing for the flags. There are no branches, so that compilers
+// can vectorize the loop. The words are 32 bits wide, since comparing wider
+// ones takes more than SSE2.
+static void classifyPrefixes(const uint32_t *Heads, const uint32_t *Nexts,
+    size_t N, DemangleScheme *Schemes, bool Strip, bool Microsoft)
+{
+    for (size_t I = 0; I < N; ++I)
+    {
+        uint32_t Head = Heads[I];
+        uint32_t Next = Nexts[I];
+        uint32_t Underscore = (Head & 0xFF) == '_';
+        uint32_t AsIs = Strip ? 0 : nonMicrosoftScheme(Head);
+        uint32_t Dropped = Underscore ? nonMicrosoftScheme(Next) : 0;
+        uint32_t Scheme = AsIs != 0 ? AsIs : Dropped;
+
+        uint32_t First = (Strip ? (Underscore ? Next : 0) : Head) & 0xFF;
+        uint32_t MSPrefix = (First == '?') | (First == '.');
+        // A select, as an if would keep this from being vectorized.
+        Scheme = Scheme == 0 && Microsoft && MSPrefix ?
+            uint32_t(DemangleScheme::Microsoft) :
+            Scheme;
+        Schemes[I] = DemangleScheme(Scheme);
+    }
+}
+
+void llvm::classifyBatch(const char *const *Names, const size_t *Lengths,
+    size_t Count, DemangleScheme *Schemes, DemangleFlags Flags)
+{
+    constexpr size_t Chunk = 256;
+    uint32_t Heads[Chunk];
+    uint32_t Nexts[Chunk];
+    for (size_t Begin = 0; Begin < Count; Begin += Chunk)
+    {
+        size_t N = Count - Begin < Chunk ? Count - Begin : Chunk;
+        for (size_t I = 0; I < N; ++I)
+        {
+            const char *Name = Names[Begin + I];
+            size_t Length = Name != nullptr ? Lengths[Begin + I] : 0;
+            Heads[I] = loadPrefix(Name, Length, 0);
+            Nexts[I] = loadPrefix(Name, Length, 1);
+        }
+        classifyPrefixes(Heads, Nexts, N, Schemes + Begin,
+            Flags & DF_StripUnderscore, !(Flags & DF_NoMicrosoft));
+    }
+}
+
+void llvm::demangleBatch(const char *const *Names, const size_t *Lengths,
+    size_t Count, DemangledName *Results, DemangleFlags Flags)
+{
+    constexpr size_t Chunk = 256;
+    constexpr unsigned NumSchemes = unsigned(DemangleScheme::Microsoft) + 1;
+    DemangleScheme Schemes[Chunk];
+    uint16_t Order[Chunk];
+    for (size_t Begin = 0; Begin < Count; Begin += Chunk)
+    {
+        size_t N = Count - Begin < Chunk ? Count - Begin : Chunk;
+        classifyBatch(Names + Begin, Lengths + Begin, N, Schemes, Flags);
+
+        // Sort the chunk by scheme, keeping the order within each.
+        size_t Starts[NumSchemes + 1] = {};
+        for (size_t I = 0; I < N; ++I)
+            ++Starts[unsigned(Schemes[I]) + 1];
+        for (unsigned S = 1; S <= NumSchemes; ++S)
+            Starts[S] += Starts[S - 1];
+        for (size_t I = 0; I < N; ++I)
+            Order[Starts[unsigned(Schemes[I])]++] = uint16_t(I);
+
+        for (size_t J = 0; J < N; ++J)
+        {
+            size_t I = Begin + Order[J];
+            Results[I] = demangle(Names[I], Lengths[I], Schemes[Order[J]],
+                Flags);
+        }
+    }
+}
+
+// Finds the Scheme symbol in MangledName, dropping the underscore in front of
+// it like classify() does. Returns false if Flags say it isn't a symbol.
+static bool findSchemeSymbol(StringView &MangledName, DemangleScheme Scheme,
+    llvm::DemangleFlags Flags)
+{
+    if (Scheme == DemangleScheme::Unknown)
+        return false;
+    if (Scheme == DemangleScheme::Microsoft && (Flags & llvm::DF_NoMicrosoft))
+        return false;
+    if (Flags & llvm::DF_StripUnderscore)
+        return MangledName.consumeFront('_');
+
+    if (Scheme != DemangleScheme::Microsoft && MangledName.startsWith('_')
+        && !hasSchemePrefix(MangledName, Scheme)
+        && hasSchemePrefix(MangledName.dropFront(1), Scheme))
+        MangledName = MangledName.dropFront(1);
+    return true;
+}
+
+llvm::DemangledName llvm::demangle(const char *MangledName,
+    DemangleScheme Scheme, DemangleFlags Flags)
+{
+    if (MangledName == nullptr)
+        return DemangledName();
+    return demangle(MangledName, std::strlen(MangledName), Scheme, Flags);
+}
+
+llvm::DemangledName llvm::demangle(const char *MangledName, size_t Length,
+    DemangleScheme Scheme, DemangleFlags Flags)
+{
+    DemangledName Result;
+    if (MangledName == nullptr)
         return Result;
+
+    StringView Mangled(MangledName, Length);
+    StringView Symbol = Mangled;
+    if (!findSchemeSymbol(Symbol, Scheme, Flags))
+        Scheme = DemangleScheme::Unknown;
+
+    Result.Heap = fillDemangledName(Mangled, Result.Inline, Result.Size,
+        [Symbol, Scheme](char *Buf, size_t BufSize, void *Scratch,
+            size_t ScratchSize) {
+            return demangleSchemeNoHeap(Symbol, Scheme, Buf, BufSize, Scratch,
+                ScratchSize);
+        },
+        [Symbol, Scheme]() { return demangleScheme(Symbol, Scheme); });
+    return Result;
+}
+
+bool llvm::demangleAppend(const char *MangledName, std::string &Out)
+{
+    if (MangledName == nullptr)
+        return false;
+    return demangleAppend(MangledName, std::strlen(MangledName), Out);
+}
+
+bool llvm::demangleAppend(const char *MangledName, size_t Length,
+    std::string &Out)
+{
+    if (MangledName == nullptr)
+        return false;
+
+    // Print into room made at the end of Out, which only allocates when Out
+    // has to grow. Demangled names rarely run to more than a few times the
+    // length of the mangled ones; longer ones take the heap below. The room
+    // is bounded rather than all of Out's capacity, so that appending to a
+    // string with plenty of it reserved doesn't clear it all every time.
+    StringView Mangled(MangledName, Length);
+    size_t Start = Out.size();
+    size_t Room = 4 * Length + 64;
+    Out.resize(Start + Room);
+    alignas(std::max_align_t) char Scratch[8192];
+    // Out's own terminator makes up the last byte of the buffer.
+    int Status = demangleWithAnySchemeNoHeap(Mangled, &Out[Start], Room + 1,
+        Scratch, sizeof(Scratch));
+    if (Status == demangle_success)
+    {
+        Out.resize(Start + std::strlen(&Out[Start]));
+        return true;
+    }
+    Out.resize(Start);
+
+    if (Status != demangle_invalid_mangled_name)
+    {
+        if (char *Demangled = demangleWithAnyScheme(Mangled))
+        {
+            Out += Demangled;
+            std::free(Demangled);
+            return true;
+        }
+    }
+    Out.append(MangledName, Length);
+    return false;
+}
+
+static bool isDigit(char C)
+{
+    return '0' <= C && C <= '9';
+}
+
+// Consumes the first clone suffix of S, a known name followed by any
+// numbers: ".cold", ".part.0" or ".cold.1.2".
+static bool consumeCloneSuffix(StringView &S)
+{
+    static const StringView Names[] = {
+        "cold", "part", "isra", "constprop", "clone", "lto_priv", "localalias",
+        "llvm", "__uniq", "specialized", "cfi", "cfi_jt",
+    };
+
+    StringView Rest = S;
+    if (!Rest.consumeFront('.'))
+        return false;
+    size_t NameLength = 0;
+    while (NameLength < Rest.size() && Rest[NameLength] != '.')
+        ++NameLength;
+    bool Known = false;
+    for (StringView Name : Names)
+        Known |= Rest.substr(0, NameLength) == Name;
+    if (!Known)
+        return false;
+    Rest = Rest.dropFront(NameLength);
+
+    while (Rest.size() >= 2 && Rest[0] == '.' && isDigit(Rest[1]))
+    {
+        Rest = Rest.dropFront(1);
+        while (!Rest.empty() && isDigit(Rest.front()))
+            Rest = Rest.dropFront(1);
     }
+    S = Rest;
+    return true;
+}
 
-    return MangledName;
+size_t llvm::splitCloneSuffixes(const char *MangledName, size_t Length)
+{
+    // The Itanium and Rust demanglers print everything from the first '.'
+    // after the symbol as is, and nothing but identifiers in the symbol can
+    // hold a '.'. If one did, the symbol cut off at it would run out before
+    // the identifier ends and fail to demangle, so splitting there is safe.
+    // Block invocations ("___Z") drop their suffix instead.
+    StringView Mangled(MangledName, Length);
+    if (!Mangled.startsWith("_Z") && !Mangled.startsWith("__Z")
+        && !Mangled.startsWith("_R") && !Mangled.startsWith("__R"))
+        return Length;
+
+    size_t Dot = Mangled.find('.');
+    if (Dot == StringView::npos)
+        return Length;
+    StringView Suffixes = Mangled.dropFront(Dot);
+    while (consumeCloneSuffix(Suffixes))
+        ;
+    return Suffixes.empty() ? Dot : Length;
+}
+
+size_t llvm::nextCloneSuffix(const char *Suffixes, size_t Length)
+{
+    StringView Rest(Suffixes, Length);
+    if (!consumeCloneSuffix(Rest))
+        return Length;
+    return Length - Rest.size();
+}
+
+void llvm::appendCloneSuffixes(const char *Suffixes, size_t Length,
+    std::string &Out)
+{
+    if (Length == 0)
+        return;
+    Out += " (";
+    Out.append(Suffixes, Length);
+    Out += ')';
 }
 
 bool llvm::nonMicrosoftDemangle(const char *MangledName, std::string &Result)
 {
-    char *Demangled = nullptr;
-    if (isItaniumEncoding(MangledName))
-        Demangled = itaniumDemangle(MangledName, nullptr, nullptr, nullptr);
-    else if (isRustEncoding(MangledName))
-        Demangled = rustDemangle(MangledName);
-    else if (isDLangEncoding(MangledName))
-        Demangled = dlangDemangle(MangledName);
+    return nonMicrosoftDemangle(MangledName, std::strlen(MangledName), Result);
+}
 
+bool llvm::nonMicrosoftDemangle(const char *MangledName, size_t Length,
+    std::string &Result)
+{
+    char *Demangled = ::nonMicrosoftDemangle(StringView(MangledName, Length));
     if (!Demangled)
         return false;
 
@@ -68,3 +578,68 @@ bool llvm::nonMicrosoftDemangle(const char *MangledName, std::string &Result)
     std::free(Demangled);
     return true;
 }
+
+llvm::DemangledName::DemangledName(const DemangledName &Other) :
+    Size(Other.Size)
+{
+    if (Other.Heap == nullptr)
+    {
+        std::memcpy(Inline, Other.Inline, Size + 1);
+        return;
+    }
+    Heap = static_cast<char *>(std::malloc(Size + 1));
+    if (Heap == nullptr)
+        std::terminate();
+    std::memcpy(Heap, Other.Heap, Size + 1);
+}
+
+llvm::DemangledName::DemangledName(DemangledName &&Other) :
+    Heap(Other.Heap), Size(Other.Size)
+{
+    if (Heap == nullptr)
+        std::memcpy(Inline, Other.Inline, Size + 1);
+    Other.Heap = nullptr;
+    Other.Size = 0;
+    Other.Inline[0] = '\0';
+}
+
+llvm::DemangledName &llvm::DemangledName::operator=(DemangledName Other)
+{
+    std::swap(Heap, Other.Heap);
+    std::swap(Size, Other.Size);
+    if (Heap == nullptr)
+        std::memcpy(Inline, Other.Inline, Size + 1);
+    return *this;
+}
+
+llvm::DemangledName::~DemangledName()
+{
+    std::free(Heap);
+}
+
+int llvm::demangleNoHeap(const char *MangledName, char *Buf, size_t BufSize,
+    void *Scratch, size_t ScratchSize)
+{
+    return demangleNoHeap(MangledName,
+        MangledName != nullptr ? std::strlen(MangledName) : 0, Buf, BufSize,
+        Scratch, ScratchSize);
+}
+
+int llvm::demangleNoHeap(const char *MangledName, size_t Length, char *Buf,
+    size_t BufSize, void *Scratch, size_t ScratchSize)
+{
+    if (MangledName == nullptr || Buf == nullptr || BufSize == 0)
+        return demangle_invalid_args;
+
+    int Status = demangleWithAnySchemeNoHeap(StringView(MangledName, Length),
+        Buf, BufSize, Scratch, ScratchSize);
+    if (Status != demangle_invalid_mangled_name)
+        return Status;
+
+    size_t Len = Length;
+    if (Len > BufSize - 1)
+        Len = BufSize - 1;
+    std::memcpy(Buf, MangledName, Len);
+    Buf[Len] = '\0';
+    return demangle_invalid_mangled_name;
+}
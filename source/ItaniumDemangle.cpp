@@ -20,6 +20,9 @@
 #include <cstring>
 #include <functional>
 #include <utility>
+#if DEMANGLE_HAS_ATOMIC
+#include <atomic>
+#endif
 
 using namespace llvm;
 using namespace llvm::itanium_demangle;
@@ -81,8 +84,22 @@ namespace
         alignas(long double) char InitialBuffer[AllocSize];
         BlockMeta *BlockList = nullptr;
 
+        // Blocks that reset() kept for reuse rather than freeing, up to
+        // RetainLimit bytes of them.
+        BlockMeta *SpareList = nullptr;
+        size_t SpareBytes = 0;
+        size_t RetainLimit = 0;
+
         void grow()
         {
+            if (SpareList != nullptr)
+            {
+                BlockMeta *Spare = SpareList;
+                SpareList = Spare->Next;
+                SpareBytes -= AllocSize;
+                BlockList = new (Spare) BlockMeta{ BlockList, 0 };
+                return;
+            }
             char *NewMeta = static_cast<char *>(std::malloc(AllocSize));
             if (NewMeta == nullptr)
                 std::terminate();
@@ -95,10 +112,23 @@ namespace
             BlockMeta *NewMeta = reinterpret_cast<BlockMeta *>(std::malloc(NBytes));
             if (NewMeta == nullptr)
                 std::terminate();
-            BlockList->Next = new (NewMeta) BlockMeta{ BlockList->Next, 0 };
+            // Nothing is bumped in a massive block, so record its size instead;
+            // that's how reset() tells it apart from a regular one.
+            BlockList->Next = new (NewMeta) BlockMeta{ BlockList->Next, NBytes };
             return static_cast<void *>(NewMeta + 1);
         }
 
+        void releaseSpares(size_t Limit)
+        {
+            while (SpareBytes > Limit)
+            {
+                BlockMeta *Tmp = SpareList;
+                SpareList = SpareList->Next;
+                SpareBytes -= AllocSize;
+                std::free(Tmp);
+            }
+        }
+
     public:
         BumpPointerAllocator() :
             BlockList(new(InitialBuffer) BlockMeta{ nullptr, 0 }) { }
@@ -122,15 +152,40 @@ namespace
             {
                 BlockMeta *Tmp = BlockList;
                 BlockList = BlockList->Next;
-                if (reinterpret_cast<char *>(Tmp) != InitialBuffer)
+                if (reinterpret_cast<char *>(Tmp) == InitialBuffer)
+                    continue;
+                if (Tmp->Current <= UsableAllocSize &&
+                    SpareBytes + AllocSize <= RetainLimit)
+                {
+                    Tmp->Next = SpareList;
+                    SpareList = Tmp;
+                    SpareBytes += AllocSize;
+                }
+                else
                     std::free(Tmp);
             }
             BlockList = new (InitialBuffer) BlockMeta{ nullptr, 0 };
         }
 
+        // Keep up to Bytes of blocks across reset() rather than freeing them.
+        // Massive blocks are always freed.
+        void setRetainLimit(size_t Bytes)
+        {
+            RetainLimit = Bytes;
+            releaseSpares(Bytes);
+        }
+
+        // Free the blocks kept for reuse.
+        void shrink()
+        {
+            releaseSpares(0);
+        }
+
         ~BumpPointerAllocator()
         {
+            RetainLimit = 0;
             reset();
+            shrink();
         }
     };
 
@@ -144,6 +199,16 @@ namespace
             Alloc.reset();
         }
 
+        void setRetainLimit(size_t Bytes)
+        {
+            Alloc.setRetainLimit(Bytes);
+        }
+
+        void shrink()
+        {
+            Alloc.shrink();
+        }
+
         template<typename T, typename... Args>
         T *makeNode(Args &&...args)
         {
@@ -164,8 +229,235 @@ namespace
 
 using Demangler = itanium_demangle::ManglingParser<DefaultAllocator>;
 
+namespace
+{
+    // Prints the most common kind of name, a function or variable with no
+    // templates or substitutions such as _ZN2ns3Foo3barEPKci, in one pass
+    // straight into an OutputBuffer, without building an AST first. Names
+    // are made of source names after an optional St, and parameters of
+    // builtin types, class names and pointers, references and const versions
+    // of those. print() returns false as soon as anything else turns up,
+    // having printed part of the name, and the caller goes on to the parser,
+    // which prints exactly the same for every name accepted here.
+    class SimpleNamePrinter
+    {
+        StringView Rest;
+        OutputBuffer &OB;
+
+        bool printSourceName()
+        {
+            if (Rest.empty() || Rest.front() < '1' || Rest.front() > '9')
+                return false;
+            size_t Length = 0;
+            while (!Rest.empty() && Rest.front() >= '0' && Rest.front() <= '9')
+            {
+                Length = Length * 10 + static_cast<size_t>(Rest.popFront() - '0');
+                if (Length > Rest.size())
+                    return false;
+            }
+            StringView Name(Rest.begin(), Rest.begin() + Length);
+            Rest = Rest.dropFront(Length);
+            if (Name.startsWith("_GLOBAL__N"))
+                OB += "(anonymous namespace)";
+            else
+                OB += Name;
+            return true;
+        }
+
+        // <nested-name> without the N and qualifiers:
+        //     [St] <source-name>+ E
+        bool printNestedName()
+        {
+            bool NeedSeparator = false;
+            if (Rest.consumeFront("St"))
+            {
+                OB += "std";
+                NeedSeparator = true;
+            }
+            do
+            {
+                if (NeedSeparator)
+                    OB += "::";
+                Rest.consumeFront('L');
+                if (!printSourceName())
+                    return false;
+                NeedSeparator = true;
+            } while (!Rest.consumeFront('E'));
+            return true;
+        }
+
+        static StringView builtinTypeName(char C)
+        {
+            switch (C)
+            {
+                case 'v': return "void";
+                case 'w': return "wchar_t";
+                case 'b': return "bool";
+                case 'c': return "char";
+                case 'a': return "signed char";
+                case 'h': return "unsigned char";
+                case 's': return "short";
+                case 't': return "unsigned short";
+                case 'i': return "int";
+                case 'j': return "unsigned int";
+                case 'l': return "long";
+                case 'm': return "unsigned long";
+                case 'x': return "long long";
+                case 'y': return "unsigned long long";
+                case 'n': return "__int128";
+                case 'o': return "unsigned __int128";
+                case 'f': return "float";
+                case 'd': return "double";
+                case 'e': return "long double";
+                case 'g': return "__float128";
+                case 'z': return "...";
+                default: return StringView();
+            }
+        }
+
+        bool printType()
+        {
+            // Qualifiers and declarators are printed after the type they
+            // apply to, innermost first. A reference only comes outermost,
+            // where it can't collapse with another.
+            char Declarators[8];
+            size_t NumDeclarators = 0;
+            while (!Rest.empty() && NumDeclarators < sizeof(Declarators))
+            {
+                char C = Rest.front();
+                bool Outermost = NumDeclarators == 0;
+                bool AfterConst = !Outermost && Declarators[NumDeclarators - 1] == 'K';
+                if (C != 'P' && !(C == 'K' && !AfterConst) && !((C == 'R' || C == 'O') && Outermost))
+                    break;
+                Declarators[NumDeclarators++] = Rest.popFront();
+            }
+
+            if (Rest.empty())
+                return false;
+            StringView Builtin = builtinTypeName(Rest.front());
+            if (!Builtin.empty())
+            {
+                Rest = Rest.dropFront();
+                OB += Builtin;
+            }
+            else if (Rest.consumeFront('N'))
+            {
+                if (Rest.empty() || std::strchr("rVKRO", Rest.front()) != nullptr)
+                    return false;
+                if (!printNestedName())
+                    return false;
+            }
+            else if (!printSourceName())
+                return false;
+
+            while (NumDeclarators != 0)
+            {
+                switch (Declarators[--NumDeclarators])
+                {
+                    case 'P':
+                        OB += "*";
+                        break;
+                    case 'K':
+                        OB += " const";
+                        break;
+                    case 'R':
+                        OB += "&";
+                        break;
+                    case 'O':
+                        OB += "&&";
+                        break;
+                }
+            }
+            return true;
+        }
+
+    public:
+        SimpleNamePrinter(StringView Mangled, OutputBuffer &OB_) :
+            Rest(Mangled), OB(OB_) { }
+
+        bool print()
+        {
+            if (!Rest.consumeFront("_Z") && !Rest.consumeFront("__Z"))
+                return false;
+
+            // <name>, remembering the qualifiers of a member function.
+            bool Const = false, Volatile = false, Restrict = false;
+            StringView RefQualifier;
+            if (Rest.consumeFront('N'))
+            {
+                Restrict = Rest.consumeFront('r');
+                Volatile = Rest.consumeFront('V');
+                Const = Rest.consumeFront('K');
+                if (Rest.consumeFront('O'))
+                    RefQualifier = " &&";
+                else if (Rest.consumeFront('R'))
+                    RefQualifier = " &";
+                if (!printNestedName())
+                    return false;
+            }
+            else
+            {
+                if (Rest.consumeFront("St"))
+                    OB += "std::";
+                Rest.consumeFront('L');
+                if (!printSourceName())
+                    return false;
+            }
+
+            // A variable has no parameters.
+            if (!Rest.empty() && !Rest.startsWith('.'))
+            {
+                OB.printOpen();
+                if (!Rest.consumeFront('v'))
+                {
+                    bool FirstParam = true;
+                    do
+                    {
+                        if (!FirstParam)
+                            OB += ", ";
+                        FirstParam = false;
+                        if (!printType())
+                            return false;
+                    } while (!Rest.empty() && !Rest.startsWith('.'));
+                }
+                OB.printClose();
+                if (Const)
+                    OB += " const";
+                if (Volatile)
+                    OB += " volatile";
+                if (Restrict)
+                    OB += " restrict";
+                OB += RefQualifier;
+            }
+
+            // Clone suffixes, like DotSuffix.
+            if (Rest.startsWith('.'))
+            {
+                OB += " (";
+                OB += Rest;
+                OB += ")";
+                Rest = StringView();
+            }
+            return Rest.empty();
+        }
+    };
+} // unnamed namespace
+
+static bool printSimpleName(const char *MangledName, size_t Length,
+    OutputBuffer &OB)
+{
+    return SimpleNamePrinter(StringView(MangledName, MangledName + Length), OB).print();
+}
+
 char *llvm::itaniumDemangle(const char *MangledName, char *Buf,
     size_t *N, int *Status)
+{
+    return itaniumDemangle(MangledName,
+        MangledName != nullptr ? std::strlen(MangledName) : 0, Buf, N, Status);
+}
+
+char *llvm::itaniumDemangle(const char *MangledName, size_t Length, char *Buf,
+    size_t *N, int *Status)
 {
     if (MangledName == nullptr || (Buf != nullptr && N == nullptr))
     {
@@ -174,16 +466,89 @@ char *llvm::itaniumDemangle(const char *MangledName, char *Buf,
         return nullptr;
     }
 
+    // Simple names don't need the parser. Measure them first, so that a
+    // buffer we allocate is sized exactly and one that doesn't work out is
+    // given up before anything is printed.
+    char Window[256];
+    OutputBuffer Counter(OutputBuffer::CountOnly(), Window, sizeof(Window));
+    if (printSimpleName(MangledName, Length, Counter))
+    {
+        size_t Capacity = Buf != nullptr ? *N : Counter.getCurrentPosition() + 1;
+        if (Buf == nullptr)
+        {
+            Buf = static_cast<char *>(std::malloc(Capacity));
+            if (Buf == nullptr)
+                std::terminate();
+        }
+        OutputBuffer OB(Buf, Capacity);
+        printSimpleName(MangledName, Length, OB);
+        OB += '\0';
+        if (N != nullptr)
+            *N = OB.getCurrentPosition();
+        if (Status)
+            *Status = demangle_success;
+        return OB.getBuffer();
+    }
+
     int InternalStatus = demangle_success;
-    Demangler Parser(MangledName, MangledName + std::strlen(MangledName));
+    Demangler Parser(MangledName, MangledName + Length);
     Node *AST = Parser.parse();
 
     if (AST == nullptr)
         InternalStatus = demangle_invalid_mangled_name;
     else
     {
-        OutputBuffer OB(Buf, N);
         assert(Parser.ForwardTemplateRefs.empty());
+        size_t Capacity = Buf != nullptr && N != nullptr ? *N : 0;
+        if (Buf == nullptr)
+            Buf = allocateExactBuffer(
+                [AST](OutputBuffer &Counter) { AST->print(Counter); },
+                Capacity);
+        OutputBuffer OB(Buf, Capacity);
+        AST->print(OB);
+        OB += '\0';
+        if (N != nullptr)
+            *N = OB.getCurrentPosition();
+        Buf = OB.getBuffer();
+    }
+
+    if (Status)
+        *Status = InternalStatus;
+    return InternalStatus == demangle_success ? Buf : nullptr;
+}
+
+char *llvm::itaniumDemangleTypeName(const char *MangledName, size_t Length,
+    char *Buf, size_t *N, int *Status)
+{
+    if (MangledName == nullptr || (Buf != nullptr && N == nullptr))
+    {
+        if (Status)
+            *Status = demangle_invalid_args;
+        return nullptr;
+    }
+
+    // GCC starts the names of types with internal linkage with a '*', which
+    // type_info::name() skips but the type_info's own copy keeps.
+    if (Length != 0 && *MangledName == '*')
+    {
+        ++MangledName;
+        --Length;
+    }
+
+    int InternalStatus = demangle_success;
+    Demangler Parser(MangledName, MangledName + Length);
+    Node *AST = Parser.parseType();
+
+    if (AST == nullptr || Parser.numLeft() != 0)
+        InternalStatus = demangle_invalid_mangled_name;
+    else
+    {
+        size_t Capacity = Buf != nullptr ? *N : 0;
+        if (Buf == nullptr)
+            Buf = allocateExactBuffer(
+                [AST](OutputBuffer &Counter) { AST->print(Counter); },
+                Capacity);
+        OutputBuffer OB(Buf, Capacity);
         AST->print(OB);
         OB += '\0';
         if (N != nullptr)
@@ -196,6 +561,236 @@ char *llvm::itaniumDemangle(const char *MangledName, char *Buf,
     return InternalStatus == demangle_success ? Buf : nullptr;
 }
 
+#if DEMANGLE_HAS_ATOMIC
+namespace
+{
+    // Open addressing with linear probing, like the Microsoft type name
+    // cache, but shared by all threads. A slot only ever goes from null to an
+    // entry that never changes after, so adding one is a single
+    // compare-and-swap and finding one never waits. Instead of being rehashed,
+    // a table that fills up gets a twice as large one chained after it, which
+    // takes the new entries; lookups go through the whole chain.
+    class SharedTypeNameCache
+    {
+        struct Entry
+        {
+            const char *Name;
+            char *Demangled;
+        };
+
+        struct Table
+        {
+            size_t Capacity = 0;
+            std::atomic<size_t> Count{ 0 };
+            std::atomic<Table *> Next{ nullptr };
+            std::atomic<Entry *> *Slots = nullptr;
+        };
+
+        std::atomic<Table *> First{ nullptr };
+
+        static size_t hash(const char *Name)
+        {
+            uintptr_t H = reinterpret_cast<uintptr_t>(Name);
+            H ^= H >> 17;
+            H *= 0x9e3779b1u;
+            return H ^ (H >> 15);
+        }
+
+        static Table *makeTable(size_t Capacity)
+        {
+            void *Mem = std::malloc(sizeof(Table) + Capacity * sizeof(std::atomic<Entry *>));
+            if (Mem == nullptr)
+                std::terminate();
+            Table *T = new (Mem) Table;
+            T->Capacity = Capacity;
+            T->Slots = reinterpret_cast<std::atomic<Entry *> *>(T + 1);
+            for (size_t I = 0; I < Capacity; ++I)
+                new (&T->Slots[I]) std::atomic<Entry *>(nullptr);
+            return T;
+        }
+
+        // Returns the table after T, adding one if there isn't any yet.
+        static Table *nextTable(Table *T)
+        {
+            Table *Next = T->Next.load(std::memory_order_acquire);
+            if (Next != nullptr)
+                return Next;
+            Table *Bigger = makeTable(T->Capacity * 2);
+            if (T->Next.compare_exchange_strong(Next, Bigger,
+                    std::memory_order_acq_rel, std::memory_order_acquire))
+                return Bigger;
+            std::free(Bigger);
+            return Next;
+        }
+
+        static const Entry *find(const Table *T, const char *Name)
+        {
+            for (size_t I = hash(Name), Probes = 0; Probes < T->Capacity; ++I, ++Probes)
+            {
+                const Entry *E = T->Slots[I & (T->Capacity - 1)].load(std::memory_order_acquire);
+                if (E == nullptr)
+                    return nullptr;
+                if (E->Name == Name)
+                    return E;
+            }
+            return nullptr;
+        }
+
+        // Adds New to T or a table after it, unless another thread got there
+        // first with the same name, in which case New is thrown away for the
+        // entry already there.
+        static const Entry *insert(Table *T, Entry *New)
+        {
+            for (;; T = nextTable(T))
+            {
+                if ((T->Count.load(std::memory_order_relaxed) + 1) * 4 > T->Capacity * 3)
+                    continue;
+                for (size_t I = hash(New->Name), Probes = 0; Probes < T->Capacity; ++I, ++Probes)
+                {
+                    std::atomic<Entry *> &Slot = T->Slots[I & (T->Capacity - 1)];
+                    Entry *E = Slot.load(std::memory_order_acquire);
+                    if (E == nullptr)
+                    {
+                        if (Slot.compare_exchange_strong(E, New,
+                                std::memory_order_acq_rel, std::memory_order_acquire))
+                        {
+                            T->Count.fetch_add(1, std::memory_order_relaxed);
+                            return New;
+                        }
+                    }
+                    if (E->Name == New->Name)
+                    {
+                        std::free(New->Demangled);
+                        delete New;
+                        return E;
+                    }
+                }
+            }
+        }
+
+    public:
+        // Entries and tables are never freed, so that results stay valid
+        // until the process exits, whatever order static objects are
+        // destroyed in.
+        const char *get(const char *Name)
+        {
+            Table *T = First.load(std::memory_order_acquire);
+            if (T == nullptr)
+            {
+                Table *Initial = makeTable(64);
+                if (First.compare_exchange_strong(T, Initial,
+                        std::memory_order_acq_rel, std::memory_order_acquire))
+                    T = Initial;
+                else
+                    std::free(Initial);
+            }
+
+            // Failures are cached too, as null results.
+            for (;;)
+            {
+                if (const Entry *E = find(T, Name))
+                    return E->Demangled;
+                Table *Next = T->Next.load(std::memory_order_acquire);
+                if (Next == nullptr)
+                    break;
+                T = Next;
+            }
+
+            char *Demangled = itaniumDemangleTypeName(Name, std::strlen(Name),
+                nullptr, nullptr, nullptr);
+            return insert(T, new Entry{ Name, Demangled })->Demangled;
+        }
+    };
+
+    // Constant-initialized, and trivially destructible.
+    SharedTypeNameCache TypeNameCache;
+} // unnamed namespace
+
+const char *llvm::itaniumDemangleTypeNameCached(const char *MangledName)
+{
+    if (MangledName == nullptr)
+        return nullptr;
+    return TypeNameCache.get(MangledName);
+}
+#endif
+
+namespace
+{
+    // Node allocator for itaniumDemangleNoHeap(). Once the region runs out,
+    // makeNode() returns nullptr, which the parser treats like any other
+    // failed production; the caller sees the exhausted region and throws the
+    // AST away.
+    class ScratchAllocator
+    {
+        ScratchRegion *Region = nullptr;
+
+    public:
+        void setRegion(ScratchRegion &R)
+        {
+            Region = &R;
+        }
+
+        void reset() { }
+
+        template<typename T, typename... Args>
+        T *makeNode(Args &&...args)
+        {
+            void *Mem = Region->allocate(sizeof(T), alignof(T));
+            if (Mem == nullptr)
+                return nullptr;
+            return new (Mem) T(std::forward<Args>(args)...);
+        }
+
+        void *allocateNodeArray(size_t sz)
+        {
+            return Region->allocate(sizeof(Node *) * sz, alignof(Node *));
+        }
+    };
+} // unnamed namespace
+
+int llvm::itaniumDemangleNoHeap(const char *MangledName, char *Buf,
+    size_t BufSize, void *Scratch, size_t ScratchSize)
+{
+    return itaniumDemangleNoHeap(MangledName,
+        MangledName != nullptr ? std::strlen(MangledName) : 0, Buf, BufSize,
+        Scratch, ScratchSize);
+}
+
+int llvm::itaniumDemangleNoHeap(const char *MangledName, size_t Length,
+    char *Buf, size_t BufSize, void *Scratch, size_t ScratchSize)
+{
+    if (MangledName == nullptr || Buf == nullptr || BufSize == 0)
+        return demangle_invalid_args;
+
+    {
+        OutputBuffer OB(Buf, BufSize - 1, /*FixedSize=*/true);
+        if (printSimpleName(MangledName, Length, OB))
+        {
+            OB.getBuffer()[OB.getCurrentPosition()] = '\0';
+            return OB.isTruncated() ? demangle_truncated : demangle_success;
+        }
+    }
+    *Buf = '\0';
+
+    ScratchRegion Region(Scratch, ScratchSize);
+    ManglingParser<ScratchAllocator> Parser(MangledName, MangledName + Length);
+    Parser.ASTAllocator.setRegion(Region);
+    Parser.useScratch(Region);
+
+    Node *AST = Parser.parse();
+    if (Region.exhausted())
+        return demangle_memory_alloc_failure;
+    if (AST == nullptr)
+        return demangle_invalid_mangled_name;
+
+    // Keep the last byte for the terminator.
+    OutputBuffer OB(Buf, BufSize - 1, /*FixedSize=*/true);
+    assert(Parser.ForwardTemplateRefs.empty());
+    AST->print(OB);
+    OB.getBuffer()[OB.getCurrentPosition()] = '\0';
+    return OB.isTruncated() ? demangle_truncated : demangle_success;
+}
+
 ItaniumPartialDemangler::ItaniumPartialDemangler() :
     RootNode(nullptr), Context(new Demangler{ nullptr, nullptr }) { }
 
@@ -207,7 +802,9 @@ ItaniumPartialDemangler::~ItaniumPartialDemangler()
 ItaniumPartialDemangler::ItaniumPartialDemangler(
     ItaniumPartialDemangler &&Other) :
     RootNode(Other.RootNode),
-    Context(Other.Context)
+    Context(Other.Context),
+    RetainedMemory(Other.RetainedMemory),
+    LimitsRetainedMemory(Other.LimitsRetainedMemory)
 {
     Other.Context = Other.RootNode = nullptr;
 }
@@ -217,22 +814,60 @@ operator=(ItaniumPartialDemangler &&Other)
 {
     std::swap(RootNode, Other.RootNode);
     std::swap(Context, Other.Context);
+    std::swap(RetainedMemory, Other.RetainedMemory);
+    std::swap(LimitsRetainedMemory, Other.LimitsRetainedMemory);
     return *this;
 }
 
+void ItaniumPartialDemangler::setRetainedMemory(size_t Bytes)
+{
+    RetainedMemory = Bytes;
+    LimitsRetainedMemory = true;
+}
+
+void ItaniumPartialDemangler::shrink()
+{
+    // The AST lives in the arena's blocks in use, and doesn't refer to the
+    // parser's tables once parsed, so both can go.
+    Demangler *Parser = static_cast<Demangler *>(Context);
+    if (Parser == nullptr)
+        return;
+    Parser->trimTables(0);
+    Parser->ASTAllocator.shrink();
+}
+
 // Demangle MangledName into an AST, storing it into this->RootNode.
 bool ItaniumPartialDemangler::partialDemangle(const char *MangledName)
+{
+    return partialDemangle(MangledName, std::strlen(MangledName));
+}
+
+bool ItaniumPartialDemangler::partialDemangle(const char *MangledName,
+    size_t Length)
 {
     Demangler *Parser = static_cast<Demangler *>(Context);
-    size_t Len = std::strlen(MangledName);
-    Parser->reset(MangledName, MangledName + Len);
+    if (LimitsRetainedMemory)
+    {
+        // Whatever the tables don't keep of the retained memory goes to the
+        // arena.
+        size_t Kept = Parser->trimTables(RetainedMemory);
+        Parser->ASTAllocator.setRetainLimit(RetainedMemory - Kept);
+    }
+    Parser->reset(MangledName, MangledName + Length);
     RootNode = Parser->parse();
     return RootNode == nullptr;
 }
 
 static char *printNode(const Node *RootNode, char *Buf, size_t *N)
 {
-    OutputBuffer OB(Buf, N);
+    // When we allocate the buffer, size it exactly so that printing never
+    // reallocates.
+    size_t Capacity = Buf != nullptr ? *N : 0;
+    if (Buf == nullptr)
+        Buf = allocateExactBuffer(
+            [RootNode](OutputBuffer &Counter) { RootNode->print(Counter); },
+            Capacity);
+    OutputBuffer OB(Buf, Capacity);
     RootNode->print(OB);
     OB += '\0';
     if (N != nullptr)
@@ -24,6 +24,7 @@
 #include <array>
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 #include <tuple>
 
 using namespace llvm;
@@ -34,12 +35,6 @@ static bool startsWithDigit(StringView S)
     return !S.empty() && std::isdigit(S.front());
 }
 
-struct NodeList
-{
-    Node *N = nullptr;
-    NodeList *Next = nullptr;
-};
-
 static bool isMemberPointer(StringView MangledName, bool &Error)
 {
     Error = false;
@@ -271,6 +266,9 @@ demanglePointerCVQualifiers(StringView &MangledName)
 StringView Demangler::copyString(StringView Borrowed)
 {
     char *Stable = Arena.allocUnalignedBuffer(Borrowed.size());
+    // Out of scratch memory; the demangler has failed already.
+    if (Stable == nullptr)
+        return {};
     // This is not a micro-optimization, it avoids UB, should Borrowed be an null
     // buffer.
     if (Borrowed.size())
@@ -284,6 +282,9 @@ Demangler::demangleSpecialTableSymbolNode(StringView &MangledName,
     SpecialIntrinsicKind K)
 {
     NamedIdentifierNode *NI = Arena.alloc<NamedIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (NI == nullptr)
+        return nullptr;
     switch (K)
     {
         case SpecialIntrinsicKind::Vftable:
@@ -303,6 +304,8 @@ Demangler::demangleSpecialTableSymbolNode(StringView &MangledName,
     }
     QualifiedNameNode *QN = demangleNameScopeChain(MangledName, NI);
     SpecialTableSymbolNode *STSN = Arena.alloc<SpecialTableSymbolNode>();
+    if (STSN == nullptr)
+        return nullptr;
     STSN->Name = QN;
     bool IsMember = false;
     if (MangledName.empty())
@@ -328,10 +331,15 @@ Demangler::demangleLocalStaticGuard(StringView &MangledName, bool IsThread)
 {
     LocalStaticGuardIdentifierNode *LSGI =
         Arena.alloc<LocalStaticGuardIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (LSGI == nullptr)
+        return nullptr;
     LSGI->IsThread = IsThread;
     QualifiedNameNode *QN = demangleNameScopeChain(MangledName, LSGI);
     LocalStaticGuardVariableNode *LSGVN =
         Arena.alloc<LocalStaticGuardVariableNode>();
+    if (LSGVN == nullptr)
+        return nullptr;
     LSGVN->Name = QN;
 
     if (MangledName.consumeFront("4IA"))
@@ -353,6 +361,9 @@ static NamedIdentifierNode *synthesizeNamedIdentifier(ArenaAllocator &Arena,
     StringView Name)
 {
     NamedIdentifierNode *Id = Arena.alloc<NamedIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (Id == nullptr)
+        return nullptr;
     Id->Name = Name;
     return Id;
 }
@@ -361,10 +372,15 @@ static QualifiedNameNode *synthesizeQualifiedName(ArenaAllocator &Arena,
     IdentifierNode *Identifier)
 {
     QualifiedNameNode *QN = Arena.alloc<QualifiedNameNode>();
-    QN->Components = Arena.alloc<NodeArrayNode>();
-    QN->Components->Count = 1;
-    QN->Components->Nodes = Arena.allocArray<Node *>(1);
-    QN->Components->Nodes[0] = Identifier;
+    NodeArrayNode *Components = Arena.alloc<NodeArrayNode>();
+    Node **Nodes = Arena.allocArray<Node *>(1);
+    // Out of scratch memory; the demangler has failed already.
+    if (QN == nullptr || Components == nullptr || Nodes == nullptr)
+        return nullptr;
+    Nodes[0] = Identifier;
+    Components->Count = 1;
+    Components->Nodes = Nodes;
+    QN->Components = Components;
     return QN;
 }
 
@@ -380,6 +396,9 @@ static VariableSymbolNode *synthesizeVariable(ArenaAllocator &Arena,
     StringView VariableName)
 {
     VariableSymbolNode *VSN = Arena.alloc<VariableSymbolNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (VSN == nullptr)
+        return nullptr;
     VSN->Type = Type;
     VSN->Name = synthesizeQualifiedName(Arena, VariableName);
     return VSN;
@@ -391,6 +410,9 @@ VariableSymbolNode *Demangler::demangleUntypedVariable(
     NamedIdentifierNode *NI = synthesizeNamedIdentifier(Arena, VariableName);
     QualifiedNameNode *QN = demangleNameScopeChain(MangledName, NI);
     VariableSymbolNode *VSN = Arena.alloc<VariableSymbolNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (VSN == nullptr)
+        return nullptr;
     VSN->Name = QN;
     if (MangledName.consumeFront("8"))
         return VSN;
@@ -405,6 +427,9 @@ Demangler::demangleRttiBaseClassDescriptorNode(ArenaAllocator &Arena,
 {
     RttiBaseClassDescriptorNode *RBCDN =
         Arena.alloc<RttiBaseClassDescriptorNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (RBCDN == nullptr)
+        return nullptr;
     RBCDN->NVOffset = demangleUnsigned(MangledName);
     RBCDN->VBPtrOffset = demangleSigned(MangledName);
     RBCDN->VBTableOffset = demangleUnsigned(MangledName);
@@ -413,6 +438,8 @@ Demangler::demangleRttiBaseClassDescriptorNode(ArenaAllocator &Arena,
         return nullptr;
 
     VariableSymbolNode *VSN = Arena.alloc<VariableSymbolNode>();
+    if (VSN == nullptr)
+        return nullptr;
     VSN->Name = demangleNameScopeChain(MangledName, RBCDN);
     MangledName.consumeFront('8');
     return VSN;
@@ -423,6 +450,9 @@ FunctionSymbolNode *Demangler::demangleInitFiniStub(StringView &MangledName,
 {
     DynamicStructorIdentifierNode *DSIN =
         Arena.alloc<DynamicStructorIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (DSIN == nullptr)
+        return nullptr;
     DSIN->IsDestructor = IsDestructor;
 
     bool IsKnownStaticDataMember = false;
@@ -476,7 +506,15 @@ FunctionSymbolNode *Demangler::demangleInitFiniStub(StringView &MangledName,
 SymbolNode *Demangler::demangleSpecialIntrinsic(StringView &MangledName)
 {
     SpecialIntrinsicKind SIK = consumeSpecialIntrinsicKind(MangledName);
+    SymbolNode *S = demangleSpecialIntrinsic(MangledName, SIK);
+    if (S != nullptr)
+        S->SpecialKind = SIK;
+    return S;
+}
 
+SymbolNode *Demangler::demangleSpecialIntrinsic(StringView &MangledName,
+    SpecialIntrinsicKind SIK)
+{
     switch (SIK)
     {
         case SpecialIntrinsicKind::None:
@@ -555,6 +593,9 @@ Demangler::demangleStructorIdentifier(StringView &MangledName,
     bool IsDestructor)
 {
     StructorIdentifierNode *N = Arena.alloc<StructorIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (N == nullptr)
+        return nullptr;
     N->IsDestructor = IsDestructor;
     return N;
 }
@@ -572,6 +613,9 @@ Demangler::demangleLiteralOperatorIdentifier(StringView &MangledName)
 {
     LiteralOperatorIdentifierNode *N =
         Arena.alloc<LiteralOperatorIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (N == nullptr)
+        return nullptr;
     N->Name = demangleSimpleString(MangledName, /*Memorize=*/false);
     return N;
 }
@@ -850,6 +894,9 @@ SymbolNode *Demangler::demangleMD5Name(StringView &MangledName)
 
     StringView MD5(Start, MangledName.begin());
     SymbolNode *S = Arena.alloc<SymbolNode>(NodeKind::Md5Symbol);
+    // Out of scratch memory; the demangler has failed already.
+    if (S == nullptr)
+        return nullptr;
     S->Name = synthesizeQualifiedName(Arena, MD5);
 
     return S;
@@ -906,7 +953,7 @@ TagTypeNode *Demangler::parseTagUniqueName(StringView &MangledName)
         return nullptr;
     }
     MangledName.consumeFront(".?A");
-    if (MangledName.empty())
+    if (MangledName.empty() || !std::strchr("TUVW", MangledName.front()))
     {
         Error = true;
         return nullptr;
@@ -926,6 +973,9 @@ VariableSymbolNode *Demangler::demangleVariableEncoding(StringView &MangledName,
     StorageClass SC)
 {
     VariableSymbolNode *VSN = Arena.alloc<VariableSymbolNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (VSN == nullptr)
+        return nullptr;
 
     VSN->Type = demangleType(MangledName, QualifierMangleMode::Drop);
     VSN->SC = SC;
@@ -1035,11 +1085,19 @@ void Demangler::memorizeString(StringView S)
 {
     if (Backrefs.NamesCount >= BackrefContext::Max)
         return;
+    // FNV-1a.
+    uint32_t Hash = 2166136261u;
+    for (char C : S)
+        Hash = (Hash ^ static_cast<uint8_t>(C)) * 16777619u;
     for (size_t i = 0; i < Backrefs.NamesCount; ++i)
-        if (S == Backrefs.Names[i]->Name)
+        if (Hash == Backrefs.NameHashes[i] && S == Backrefs.Names[i]->Name)
             return;
     NamedIdentifierNode *N = Arena.alloc<NamedIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (N == nullptr)
+        return;
     N->Name = S;
+    Backrefs.NameHashes[Backrefs.NamesCount] = Hash;
     Backrefs.Names[Backrefs.NamesCount++] = N;
 }
 
@@ -1060,13 +1118,32 @@ NamedIdentifierNode *Demangler::demangleBackRefName(StringView &MangledName)
 
 void Demangler::memorizeIdentifier(IdentifierNode *Identifier)
 {
-    // Render this class template name into a string buffer so that we can
-    // memorize it for the purpose of back-referencing.
-    OutputBuffer OB;
-    Identifier->output(OB, OF_Default);
-    StringView Owned = copyString(OB);
-    memorizeString(Owned);
-    std::free(OB.getBuffer());
+    // Render this class template name into a string so that we can memorize
+    // it for the purpose of back-referencing. Don't look at nodes built after
+    // running out of scratch memory, they may be missing parts.
+    if (Backrefs.NamesCount >= BackrefContext::Max || Arena.exhausted())
+        return;
+
+    // Print straight into the free end of the arena's current block and claim
+    // what the name took. If it doesn't fit, retry in a block twice as big.
+    for (;;)
+    {
+        size_t Size = 0;
+        char *Free = Arena.freeSpace(Size);
+        OutputBuffer OB(Free, Size, /*FixedSize=*/true);
+        Identifier->output(OB, OF_Default);
+        if (!OB.isTruncated())
+        {
+            size_t Len = OB.getCurrentPosition();
+            memorizeString(StringView(Arena.allocUnalignedBuffer(Len), Len));
+            return;
+        }
+        if (!Arena.reserve(std::max(AllocUnit, 2 * Size)))
+        {
+            Arena.setExhausted();
+            return;
+        }
+    }
 }
 
 IdentifierNode *
@@ -1113,6 +1190,9 @@ NamedIdentifierNode *Demangler::demangleSimpleName(StringView &MangledName,
         return nullptr;
 
     NamedIdentifierNode *Name = Arena.alloc<NamedIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (Name == nullptr)
+        return nullptr;
     Name->Name = S;
     return Name;
 }
@@ -1292,29 +1372,57 @@ static void outputEscapedChar(OutputBuffer &OB, unsigned C)
     outputHex(OB, C);
 }
 
-static unsigned countTrailingNullBytes(const uint8_t *StringBytes, int Length)
+// String literals are mostly made of bytes that stand for themselves, both
+// mangled and printed, so they're handled a word at a time where possible.
+// These test whether any byte of a word is, or is below, a given value.
+static constexpr uint64_t everyByte(uint8_t B)
 {
-    const uint8_t *End = StringBytes + Length - 1;
-    unsigned Count = 0;
-    while (Length > 0 && *End == 0)
-    {
-        --Length;
-        --End;
-        ++Count;
-    }
-    return Count;
+    return 0x0101010101010101ull * B;
 }
 
-static unsigned countEmbeddedNulls(const uint8_t *StringBytes,
-    unsigned Length)
+static uint64_t loadWord(const void *P)
 {
-    unsigned Result = 0;
+    uint64_t Word;
+    std::memcpy(&Word, P, sizeof(Word));
+    return Word;
+}
+
+static bool hasByteBelow(uint64_t Word, uint8_t N)
+{
+    assert(N <= 128);
+    return ((Word - everyByte(N)) & ~Word & everyByte(0x80)) != 0;
+}
+
+static bool hasByte(uint64_t Word, uint8_t B)
+{
+    return hasByteBelow(Word ^ everyByte(B), 1);
+}
+
+// Whether outputEscapedChar() prints all 8 bytes of Word as they are.
+static bool isPlainWord(uint64_t Word)
+{
+    return !hasByteBelow(Word, 0x20) && !(Word & everyByte(0x80))
+        && !hasByte(Word, 0x7F) && !hasByte(Word, '\\')
+        && !hasByte(Word, '\'') && !hasByte(Word, '"');
+}
+
+// Counts the null bytes in StringBytes, and how many of them are at the end,
+// in one pass.
+static void countNullBytes(const uint8_t *StringBytes, unsigned Length,
+    unsigned &Nulls, unsigned &TrailingNulls)
+{
+    Nulls = 0;
+    TrailingNulls = 0;
     for (unsigned I = 0; I < Length; ++I)
     {
-        if (*StringBytes++ == 0)
-            ++Result;
+        if (StringBytes[I] == 0)
+        {
+            ++Nulls;
+            ++TrailingNulls;
+        }
+        else
+            TrailingNulls = 0;
     }
-    return Result;
 }
 
 // A mangled (non-wide) string literal stores the total length of the string it
@@ -1329,12 +1437,14 @@ static unsigned guessCharByteSize(const uint8_t *StringBytes, unsigned NumChars,
     if (NumBytes % 2 == 1)
         return 1;
 
+    unsigned Nulls, TrailingNulls;
+    countNullBytes(StringBytes, NumChars, Nulls, TrailingNulls);
+
     // All strings can encode at most 32 bytes of data.  If it's less than that,
     // then we encoded the entire string.  In this case we check for a 1-byte,
     // 2-byte, or 4-byte null terminator.
     if (NumBytes < 32)
     {
-        unsigned TrailingNulls = countTrailingNullBytes(StringBytes, NumChars);
         if (TrailingNulls >= 4 && NumBytes % 4 == 0)
             return 4;
         if (TrailingNulls >= 2)
@@ -1348,7 +1458,6 @@ static unsigned guessCharByteSize(const uint8_t *StringBytes, unsigned NumChars,
     // are null, it's a char16.  Otherwise it's a char8.  This obviously isn't
     // perfect and is biased towards languages that have ascii alphabets, but this
     // was always going to be best effort since the encoding is lossy.
-    unsigned Nulls = countEmbeddedNulls(StringBytes, NumChars);
     if (Nulls >= 2 * NumChars / 3 && NumBytes % 4 == 0)
         return 4;
     if (Nulls >= NumChars / 3)
@@ -1375,7 +1484,11 @@ FunctionSymbolNode *Demangler::demangleVcallThunkNode(StringView &MangledName)
 {
     FunctionSymbolNode *FSN = Arena.alloc<FunctionSymbolNode>();
     VcallThunkIdentifierNode *VTIN = Arena.alloc<VcallThunkIdentifierNode>();
-    FSN->Signature = Arena.alloc<ThunkSignatureNode>();
+    ThunkSignatureNode *Signature = Arena.alloc<ThunkSignatureNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (FSN == nullptr || VTIN == nullptr || Signature == nullptr)
+        return nullptr;
+    FSN->Signature = Signature;
     FSN->Signature->FunctionClass = FC_NoParameterList;
 
     FSN->Name = demangleNameScopeChain(MangledName, VTIN);
@@ -1394,7 +1507,7 @@ EncodedStringLiteralNode *
 Demangler::demangleStringLiteral(StringView &MangledName)
 {
     // This function uses goto, so declare all variables up front.
-    OutputBuffer OB;
+    OutputBuffer OB(TempBuf, TempBufSize, /*FixedSize=*/TempBuf != nullptr);
     StringView CRC;
     uint64_t StringByteSize;
     bool IsWcharT = false;
@@ -1402,6 +1515,10 @@ Demangler::demangleStringLiteral(StringView &MangledName)
     size_t CrcEndPos = 0;
 
     EncodedStringLiteralNode *Result = Arena.alloc<EncodedStringLiteralNode>();
+    // Out of scratch memory; the demangler has failed already. Nothing has
+    // been printed into OB yet.
+    if (Result == nullptr)
+        return nullptr;
 
     // Prefix indicating the beginning of a string literal
     if (!MangledName.consumeFront("@_"))
@@ -1465,6 +1582,18 @@ Demangler::demangleStringLiteral(StringView &MangledName)
         {
             if (MangledName.size() < 1 || BytesDecoded >= MaxStringByteLength)
                 goto StringLiteralError;
+            // Anything but '?' and '@' is mangled as itself.
+            if (MangledName.size() >= 8 && BytesDecoded + 8 <= MaxStringByteLength)
+            {
+                uint64_t Word = loadWord(MangledName.begin());
+                if (!hasByte(Word, '?') && !hasByte(Word, '@'))
+                {
+                    std::memcpy(StringBytes + BytesDecoded, MangledName.begin(), 8);
+                    BytesDecoded += 8;
+                    MangledName = MangledName.dropFront(8);
+                    continue;
+                }
+            }
             StringBytes[BytesDecoded++] = demangleCharLiteral(MangledName);
         }
 
@@ -1488,23 +1617,41 @@ Demangler::demangleStringLiteral(StringView &MangledName)
             default:
                 DEMANGLE_UNREACHABLE;
         }
+        // The last character is the terminator, unless the string was
+        // truncated.
         const unsigned NumChars = BytesDecoded / CharBytes;
-        for (unsigned CharIndex = 0; CharIndex < NumChars; ++CharIndex)
+        const unsigned NumPrinted =
+            (NumChars == 0 || Result->IsTruncated) ? NumChars : NumChars - 1;
+        for (unsigned CharIndex = 0; CharIndex < NumPrinted;)
         {
+            if (CharBytes == 1 && CharIndex + 8 <= NumPrinted
+                && isPlainWord(loadWord(StringBytes + CharIndex)))
+            {
+                OB << StringView(reinterpret_cast<const char *>(StringBytes + CharIndex), 8);
+                CharIndex += 8;
+                continue;
+            }
             unsigned NextChar =
                 decodeMultiByteChar(StringBytes, CharIndex, CharBytes);
-            if (CharIndex + 1 < NumChars || Result->IsTruncated)
-                outputEscapedChar(OB, NextChar);
+            outputEscapedChar(OB, NextChar);
+            ++CharIndex;
         }
     }
 
+    if (OB.isTruncated())
+    {
+        Arena.setExhausted();
+        return nullptr;
+    }
     Result->DecodedString = copyString(OB);
-    std::free(OB.getBuffer());
+    if (TempBuf == nullptr)
+        std::free(OB.getBuffer());
     return Result;
 
 StringLiteralError:
     Error = true;
-    std::free(OB.getBuffer());
+    if (TempBuf == nullptr)
+        std::free(OB.getBuffer());
     return nullptr;
 }
 
@@ -1539,6 +1686,9 @@ Demangler::demangleAnonymousNamespaceName(StringView &MangledName)
     MangledName.consumeFront("?A");
 
     NamedIdentifierNode *Node = Arena.alloc<NamedIdentifierNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (Node == nullptr)
+        return nullptr;
     Node->Name = "`anonymous namespace'";
     size_t EndPos = MangledName.find('@');
     if (EndPos == StringView::npos)
@@ -1567,20 +1717,28 @@ Demangler::demangleLocallyScopedNamePiece(StringView &MangledName)
     // One ? to terminate the number
     MangledName.consumeFront('?');
 
-    assert(!Error);
-    Node *Scope = parse(MangledName);
+    // Running out of scratch memory above sets Error.
     if (Error)
         return nullptr;
+    Node *Scope = parse(MangledName);
+    if (Error || Arena.exhausted())
+        return nullptr;
 
     // Render the parent symbol's name into a buffer.
-    OutputBuffer OB;
+    OutputBuffer OB(TempBuf, TempBufSize, /*FixedSize=*/TempBuf != nullptr);
     OB << '`';
     Scope->output(OB, OF_Default);
     OB << '\'';
     OB << "::`" << Number << "'";
+    if (OB.isTruncated())
+    {
+        Arena.setExhausted();
+        return nullptr;
+    }
 
     Identifier->Name = copyString(OB);
-    std::free(OB.getBuffer());
+    if (TempBuf == nullptr)
+        std::free(OB.getBuffer());
     return Identifier;
 }
 
@@ -1683,52 +1841,37 @@ IdentifierNode *Demangler::demangleNameScopePiece(StringView &MangledName)
     return demangleSimpleName(MangledName, /*Memorize=*/true);
 }
 
-static NodeArrayNode *nodeListToNodeArray(ArenaAllocator &Arena, NodeList *Head,
-    size_t Count)
-{
-    NodeArrayNode *N = Arena.alloc<NodeArrayNode>();
-    N->Count = Count;
-    N->Nodes = Arena.allocArray<Node *>(Count);
-    for (size_t I = 0; I < Count; ++I)
-    {
-        N->Nodes[I] = Head->N;
-        Head = Head->Next;
-    }
-    return N;
-}
-
 QualifiedNameNode *
 Demangler::demangleNameScopeChain(StringView &MangledName,
     IdentifierNode *UnqualifiedName)
 {
-    NodeList *Head = Arena.alloc<NodeList>();
-
-    Head->N = UnqualifiedName;
+    size_t Begin = Lists.size();
+    if (!Lists.push(Arena, UnqualifiedName))
+        return nullptr;
 
-    size_t Count = 1;
     while (!MangledName.consumeFront("@"))
     {
-        ++Count;
-        NodeList *NewHead = Arena.alloc<NodeList>();
-        NewHead->Next = Head;
-        Head = NewHead;
-
         if (MangledName.empty())
         {
             Error = true;
             return nullptr;
         }
 
-        assert(!Error);
         IdentifierNode *Elem = demangleNameScopePiece(MangledName);
-        if (Error)
+        if (Error || !Lists.push(Arena, Elem))
             return nullptr;
-
-        Head->N = Elem;
     }
 
+    // The scopes are mangled innermost first.
     QualifiedNameNode *QN = Arena.alloc<QualifiedNameNode>();
-    QN->Components = nodeListToNodeArray(Arena, Head, Count);
+    NodeArrayNode *Array = Lists.popArray(Arena, Begin);
+    // Out of scratch memory; the demangler has failed already.
+    if (QN == nullptr || Array == nullptr || Array->Nodes == nullptr)
+        return nullptr;
+    QN->Components = Array;
+    Node **Components = Array->Nodes;
+    for (size_t I = 0, J = Array->Count - 1; I < J; ++I, --J)
+        std::swap(Components[I], Components[J]);
     return QN;
 }
 
@@ -1993,6 +2136,9 @@ FunctionSignatureNode *Demangler::demangleFunctionType(StringView &MangledName,
     bool HasThisQuals)
 {
     FunctionSignatureNode *FTy = Arena.alloc<FunctionSignatureNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (FTy == nullptr)
+        return nullptr;
 
     if (HasThisQuals)
     {
@@ -2038,11 +2184,16 @@ Demangler::demangleFunctionEncoding(StringView &MangledName)
     if (FC & FC_StaticThisAdjust)
     {
         TTN = Arena.alloc<ThunkSignatureNode>();
+        // Out of scratch memory; the demangler has failed already.
+        if (TTN == nullptr)
+            return nullptr;
         TTN->ThisAdjust.StaticOffset = demangleSigned(MangledName);
     }
     else if (FC & FC_VirtualThisAdjust)
     {
         TTN = Arena.alloc<ThunkSignatureNode>();
+        if (TTN == nullptr)
+            return nullptr;
         if (FC & FC_VirtualThisAdjustEx)
         {
             TTN->ThisAdjust.VBPtrOffset = demangleSigned(MangledName);
@@ -2076,6 +2227,8 @@ Demangler::demangleFunctionEncoding(StringView &MangledName)
     FSN->FunctionClass = FC;
 
     FunctionSymbolNode *Symbol = Arena.alloc<FunctionSymbolNode>();
+    if (Symbol == nullptr)
+        return nullptr;
     Symbol->Signature = FSN;
     return Symbol;
 }
@@ -2086,6 +2239,9 @@ CustomTypeNode *Demangler::demangleCustomType(StringView &MangledName)
     MangledName.popFront();
 
     CustomTypeNode *CTN = Arena.alloc<CustomTypeNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (CTN == nullptr)
+        return nullptr;
     CTN->Identifier = demangleUnqualifiedTypeName(MangledName, /*Memorize=*/true);
     if (!MangledName.consumeFront('@'))
         Error = true;
@@ -2185,6 +2341,9 @@ TagTypeNode *Demangler::demangleClassType(StringView &MangledName)
         default:
             assert(false);
     }
+    // Out of scratch memory; the demangler has failed already.
+    if (TT == nullptr)
+        return nullptr;
 
     TT->QualifiedName = demangleFullyQualifiedTypeName(MangledName);
     return TT;
@@ -2195,6 +2354,9 @@ TagTypeNode *Demangler::demangleClassType(StringView &MangledName)
 PointerTypeNode *Demangler::demanglePointerType(StringView &MangledName)
 {
     PointerTypeNode *Pointer = Arena.alloc<PointerTypeNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (Pointer == nullptr)
+        return nullptr;
 
     std::tie(Pointer->Quals, Pointer->Affinity) =
         demanglePointerCVQualifiers(MangledName);
@@ -2215,6 +2377,9 @@ PointerTypeNode *Demangler::demanglePointerType(StringView &MangledName)
 PointerTypeNode *Demangler::demangleMemberPointerType(StringView &MangledName)
 {
     PointerTypeNode *Pointer = Arena.alloc<PointerTypeNode>();
+    // Out of scratch memory; the demangler has failed already.
+    if (Pointer == nullptr)
+        return nullptr;
 
     std::tie(Pointer->Quals, Pointer->Affinity) =
         demanglePointerCVQualifiers(MangledName);
@@ -2274,8 +2439,10 @@ ArrayTypeNode *Demangler::demangleArrayType(StringView &MangledName)
     }
 
     ArrayTypeNode *ATy = Arena.alloc<ArrayTypeNode>();
-    NodeList *Head = Arena.alloc<NodeList>();
-    NodeList *Tail = Head;
+    // Out of scratch memory; the demangler has failed already.
+    if (ATy == nullptr)
+        return nullptr;
+    size_t Begin = Lists.size();
 
     for (uint64_t I = 0; I < Rank; ++I)
     {
@@ -2286,14 +2453,11 @@ ArrayTypeNode *Demangler::demangleArrayType(StringView &MangledName)
             Error = true;
             return nullptr;
         }
-        Tail->N = Arena.alloc<IntegerLiteralNode>(D, IsNegative);
-        if (I + 1 < Rank)
-        {
-            Tail->Next = Arena.alloc<NodeList>();
-            Tail = Tail->Next;
-        }
+        IntegerLiteralNode *Dimension = Arena.alloc<IntegerLiteralNode>(D, IsNegative);
+        if (Dimension == nullptr || !Lists.push(Arena, Dimension))
+            return nullptr;
     }
-    ATy->Dimensions = nodeListToNodeArray(Arena, Head, Rank);
+    ATy->Dimensions = Lists.popArray(Arena, Begin);
 
     if (MangledName.consumeFront("$$C"))
     {
@@ -2318,13 +2482,9 @@ NodeArrayNode *Demangler::demangleFunctionParameterList(StringView &MangledName,
     if (MangledName.consumeFront('X'))
         return nullptr;
 
-    NodeList *Head = Arena.alloc<NodeList>();
-    NodeList **Current = &Head;
-    size_t Count = 0;
+    size_t Begin = Lists.size();
     while (!Error && !MangledName.startsWith('@') && !MangledName.startsWith('Z'))
     {
-        ++Count;
-
         if (startsWithDigit(MangledName))
         {
             size_t N = MangledName[0] - '0';
@@ -2335,21 +2495,17 @@ NodeArrayNode *Demangler::demangleFunctionParameterList(StringView &MangledName,
             }
             MangledName = MangledName.dropFront();
 
-            *Current = Arena.alloc<NodeList>();
-            (*Current)->N = Backrefs.FunctionParams[N];
-            Current = &(*Current)->Next;
+            if (!Lists.push(Arena, Backrefs.FunctionParams[N]))
+                return nullptr;
             continue;
         }
 
         size_t OldSize = MangledName.size();
 
-        *Current = Arena.alloc<NodeList>();
         TypeNode *TN = demangleType(MangledName, QualifierMangleMode::Drop);
-        if (!TN || Error)
+        if (!TN || Error || !Lists.push(Arena, TN))
             return nullptr;
 
-        (*Current)->N = TN;
-
         size_t CharsConsumed = OldSize - MangledName.size();
         assert(CharsConsumed != 0);
 
@@ -2357,14 +2513,12 @@ NodeArrayNode *Demangler::demangleFunctionParameterList(StringView &MangledName,
         // them doesn't save anything.
         if (Backrefs.FunctionParamCount <= 9 && CharsConsumed > 1)
             Backrefs.FunctionParams[Backrefs.FunctionParamCount++] = TN;
-
-        Current = &(*Current)->Next;
     }
 
     if (Error)
         return nullptr;
 
-    NodeArrayNode *NA = nodeListToNodeArray(Arena, Head, Count);
+    NodeArrayNode *NA = Lists.popArray(Arena, Begin);
     // A non-empty parameter list is terminated by either 'Z' (variadic) parameter
     // list or '@' (non variadic).  Careful not to consume "@Z", as in that case
     // the following Z could be a throw specifier.
@@ -2383,9 +2537,7 @@ NodeArrayNode *Demangler::demangleFunctionParameterList(StringView &MangledName,
 NodeArrayNode *
 Demangler::demangleTemplateParameterList(StringView &MangledName)
 {
-    NodeList *Head = nullptr;
-    NodeList **Current = &Head;
-    size_t Count = 0;
+    size_t Begin = Lists.size();
 
     while (!MangledName.startsWith('@'))
     {
@@ -2395,33 +2547,31 @@ Demangler::demangleTemplateParameterList(StringView &MangledName)
             continue;
         }
 
-        ++Count;
-
         // Template parameter lists don't participate in back-referencing.
-        *Current = Arena.alloc<NodeList>();
-
-        NodeList &TP = **Current;
-
+        Node *TP = nullptr;
         TemplateParameterReferenceNode *TPRN = nullptr;
         if (MangledName.consumeFront("$$Y"))
         {
             // Template alias
-            TP.N = demangleFullyQualifiedTypeName(MangledName);
+            TP = demangleFullyQualifiedTypeName(MangledName);
         }
         else if (MangledName.consumeFront("$$B"))
         {
             // Array
-            TP.N = demangleType(MangledName, QualifierMangleMode::Drop);
+            TP = demangleType(MangledName, QualifierMangleMode::Drop);
         }
         else if (MangledName.consumeFront("$$C"))
         {
             // Type has qualifiers.
-            TP.N = demangleType(MangledName, QualifierMangleMode::Mangle);
+            TP = demangleType(MangledName, QualifierMangleMode::Mangle);
         }
         else if (MangledName.startsWith("$1") || MangledName.startsWith("$H") || MangledName.startsWith("$I") || MangledName.startsWith("$J"))
         {
             // Pointer to member
-            TP.N = TPRN = Arena.alloc<TemplateParameterReferenceNode>();
+            TP = TPRN = Arena.alloc<TemplateParameterReferenceNode>();
+            // Out of scratch memory; the demangler has failed already.
+            if (TPRN == nullptr)
+                return nullptr;
             TPRN->IsMemberPointer = true;
 
             MangledName = MangledName.dropFront();
@@ -2468,13 +2618,17 @@ Demangler::demangleTemplateParameterList(StringView &MangledName)
         {
             MangledName.consumeFront("$E");
             // Reference to symbol
-            TP.N = TPRN = Arena.alloc<TemplateParameterReferenceNode>();
+            TP = TPRN = Arena.alloc<TemplateParameterReferenceNode>();
+            if (TPRN == nullptr)
+                return nullptr;
             TPRN->Symbol = parse(MangledName);
             TPRN->Affinity = PointerAffinity::Reference;
         }
         else if (MangledName.startsWith("$F") || MangledName.startsWith("$G"))
         {
-            TP.N = TPRN = Arena.alloc<TemplateParameterReferenceNode>();
+            TP = TPRN = Arena.alloc<TemplateParameterReferenceNode>();
+            if (TPRN == nullptr)
+                return nullptr;
 
             // Data member pointer.
             MangledName = MangledName.dropFront();
@@ -2504,16 +2658,14 @@ Demangler::demangleTemplateParameterList(StringView &MangledName)
             uint64_t Value = 0;
             std::tie(Value, IsNegative) = demangleNumber(MangledName);
 
-            TP.N = Arena.alloc<IntegerLiteralNode>(Value, IsNegative);
+            TP = Arena.alloc<IntegerLiteralNode>(Value, IsNegative);
         }
         else
         {
-            TP.N = demangleType(MangledName, QualifierMangleMode::Drop);
+            TP = demangleType(MangledName, QualifierMangleMode::Drop);
         }
-        if (Error)
+        if (Error || !Lists.push(Arena, TP))
             return nullptr;
-
-        Current = &TP.Next;
     }
 
     // The loop above returns nullptr on Error.
@@ -2523,20 +2675,28 @@ Demangler::demangleTemplateParameterList(StringView &MangledName)
     // by @ (as opposed to 'Z' in the function parameter case).
     assert(MangledName.startsWith('@')); // The above loop exits only on '@'.
     MangledName.consumeFront('@');
-    return nodeListToNodeArray(Arena, Head, Count);
+    return Lists.popArray(Arena, Begin);
 }
 
-char *llvm::microsoftDemangle(const char *MangledName, size_t *NMangled,
-    char *Buf, size_t *N,
-    int *Status, MSDemangleFlags Flags)
+Demangler::Demangler(void *Scratch, size_t Size) :
+    Arena(Scratch, Size, Error)
 {
-    Demangler D;
+    TempBufSize = Size / 4;
+    TempBuf = Arena.allocUnalignedBuffer(TempBufSize);
+}
 
-    StringView Name{ MangledName };
-    SymbolNode *AST = D.parse(Name);
-    if (!D.Error && NMangled)
-        *NMangled = Name.begin() - MangledName;
+void Demangler::reset()
+{
+    Arena.reset();
+    if (TempBuf != nullptr)
+        TempBuf = Arena.allocUnalignedBuffer(TempBufSize);
+    Backrefs = BackrefContext();
+    Lists.clear();
+    Error = false;
+}
 
+static OutputFlags getOutputFlags(MSDemangleFlags Flags)
+{
     OutputFlags OF = OF_Default;
     if (Flags & MSDF_NoCallingConvention)
         OF = OutputFlags(OF | OF_NoCallingConvention);
@@ -2548,13 +2708,31 @@ char *llvm::microsoftDemangle(const char *MangledName, size_t *NMangled,
         OF = OutputFlags(OF | OF_NoMemberType);
     if (Flags & MSDF_NoVariableType)
         OF = OutputFlags(OF | OF_NoVariableType);
+    return OF;
+}
+
+static char *demangleWith(Demangler &D, const char *MangledName,
+    size_t Length, size_t *NMangled, char *Buf, size_t *N, int *Status,
+    MSDemangleFlags Flags)
+{
+    StringView Name(MangledName, Length);
+    SymbolNode *AST = D.parse(Name);
+    if (!D.Error && NMangled)
+        *NMangled = Name.begin() - MangledName;
+
+    OutputFlags OF = getOutputFlags(Flags);
 
     int InternalStatus = demangle_success;
     if (D.Error)
         InternalStatus = demangle_invalid_mangled_name;
     else
     {
-        OutputBuffer OB(Buf, N);
+        size_t Capacity = Buf != nullptr && N != nullptr ? *N : 0;
+        if (Buf == nullptr)
+            Buf = itanium_demangle::allocateExactBuffer(
+                [AST, OF](OutputBuffer &Counter) { AST->output(Counter, OF); },
+                Capacity);
+        OutputBuffer OB(Buf, Capacity);
         AST->output(OB, OF);
         OB += '\0';
         if (N != nullptr)
@@ -2566,3 +2744,452 @@ char *llvm::microsoftDemangle(const char *MangledName, size_t *NMangled,
         *Status = InternalStatus;
     return InternalStatus == demangle_success ? Buf : nullptr;
 }
+
+char *llvm::microsoftDemangle(const char *MangledName, size_t *NMangled,
+    char *Buf, size_t *N,
+    int *Status, MSDemangleFlags Flags)
+{
+    return microsoftDemangle(MangledName, std::strlen(MangledName), NMangled,
+        Buf, N, Status, Flags);
+}
+
+char *llvm::microsoftDemangle(const char *MangledName, size_t Length,
+    size_t *NMangled, char *Buf, size_t *N, int *Status,
+    MSDemangleFlags Flags)
+{
+    Demangler D;
+    return demangleWith(D, MangledName, Length, NMangled, Buf, N, Status,
+        Flags);
+}
+
+MSDemangleContext::MSDemangleContext() :
+    Context(new Demangler) { }
+
+MSDemangleContext::~MSDemangleContext()
+{
+    delete static_cast<Demangler *>(Context);
+}
+
+char *llvm::microsoftDemangle(const char *MangledName, size_t *NMangled,
+    char *Buf, size_t *N,
+    int *Status, MSDemangleContext &Context,
+    MSDemangleFlags Flags)
+{
+    return microsoftDemangle(MangledName, std::strlen(MangledName), NMangled,
+        Buf, N, Status, Context, Flags);
+}
+
+char *llvm::microsoftDemangle(const char *MangledName, size_t Length,
+    size_t *NMangled, char *Buf, size_t *N, int *Status,
+    MSDemangleContext &Context, MSDemangleFlags Flags)
+{
+    Demangler *D = static_cast<Demangler *>(Context.Context);
+    D->reset();
+    return demangleWith(*D, MangledName, Length, NMangled, Buf, N, Status,
+        Flags);
+}
+
+char *llvm::microsoftDemangleTypeName(const char *MangledName, size_t Length,
+    char *Buf, size_t *N, int *Status)
+{
+    Demangler D;
+    StringView Name(MangledName, Length);
+
+    // Class types are the common case, and have a shortcut.
+    const Node *Type = nullptr;
+    if (Name.startsWith(".?A"))
+        Type = D.parseTagUniqueName(Name);
+    else if (Name.startsWith('.'))
+    {
+        SymbolNode *S = D.parse(Name);
+        if (!D.Error)
+            Type = static_cast<VariableSymbolNode *>(S)->Type;
+    }
+    else
+        D.Error = true;
+
+    if (D.Error || Type == nullptr || !Name.empty())
+    {
+        if (Status)
+            *Status = demangle_invalid_mangled_name;
+        return nullptr;
+    }
+
+    OutputBuffer OB(Buf, N);
+    Type->output(OB, OF_Default);
+    OB += '\0';
+    if (N != nullptr)
+        *N = OB.getCurrentPosition();
+    if (Status)
+        *Status = demangle_success;
+    return OB.getBuffer();
+}
+
+#if DEMANGLE_HAS_THREAD_LOCAL
+namespace
+{
+    struct TypeNameCache
+    {
+        struct Entry
+        {
+            const char *Name;
+            size_t Length;
+            char *Demangled;
+        };
+
+        // Open addressing with linear probing, on a power-of-two table.
+        Entry *Table = nullptr;
+        size_t Capacity = 0;
+        size_t Count = 0;
+
+        static size_t hash(const char *Name, size_t Length)
+        {
+            uintptr_t H = reinterpret_cast<uintptr_t>(Name) ^ (Length << 16);
+            H ^= H >> 17;
+            H *= 0x9e3779b1u;
+            return H ^ (H >> 15);
+        }
+
+        Entry *find(const char *Name, size_t Length)
+        {
+            if (Capacity == 0)
+                return nullptr;
+            for (size_t I = hash(Name, Length);; ++I)
+            {
+                Entry &E = Table[I & (Capacity - 1)];
+                if (E.Name == nullptr)
+                    return nullptr;
+                if (E.Name == Name && E.Length == Length)
+                    return &E;
+            }
+        }
+
+        void insert(Entry New)
+        {
+            if ((Count + 1) * 4 > Capacity * 3)
+            {
+                Entry *Old = Table;
+                size_t OldCapacity = Capacity;
+                Capacity = Capacity ? Capacity * 2 : 64;
+                Table = static_cast<Entry *>(std::calloc(Capacity, sizeof(Entry)));
+                if (Table == nullptr)
+                    std::terminate();
+                Count = 0;
+                for (size_t I = 0; I < OldCapacity; ++I)
+                    if (Old[I].Name != nullptr)
+                        insert(Old[I]);
+                std::free(Old);
+            }
+            for (size_t I = hash(New.Name, New.Length);; ++I)
+            {
+                Entry &E = Table[I & (Capacity - 1)];
+                if (E.Name == nullptr)
+                {
+                    E = New;
+                    ++Count;
+                    return;
+                }
+            }
+        }
+
+        ~TypeNameCache()
+        {
+            for (size_t I = 0; I < Capacity; ++I)
+                std::free(Table[I].Demangled);
+            std::free(Table);
+        }
+    };
+} // unnamed namespace
+
+const char *llvm::microsoftDemangleTypeNameCached(const char *MangledName,
+    size_t Length)
+{
+    if (MangledName == nullptr)
+        return nullptr;
+    static thread_local TypeNameCache Cache;
+    // Failures are cached too, as null results.
+    if (TypeNameCache::Entry *E = Cache.find(MangledName, Length))
+        return E->Demangled;
+    char *Demangled = microsoftDemangleTypeName(MangledName, Length, nullptr,
+        nullptr, nullptr);
+    Cache.insert({ MangledName, Length, Demangled });
+    return Demangled;
+}
+#endif
+
+MSPartialDemangler::MSPartialDemangler() :
+    RootNode(nullptr), Context(new Demangler) { }
+
+MSPartialDemangler::~MSPartialDemangler()
+{
+    delete static_cast<Demangler *>(Context);
+}
+
+MSPartialDemangler::MSPartialDemangler(MSPartialDemangler &&Other) :
+    RootNode(Other.RootNode), Context(Other.Context)
+{
+    Other.Context = Other.RootNode = nullptr;
+}
+
+MSPartialDemangler &MSPartialDemangler::operator=(MSPartialDemangler &&Other)
+{
+    std::swap(RootNode, Other.RootNode);
+    std::swap(Context, Other.Context);
+    return *this;
+}
+
+bool MSPartialDemangler::partialDemangle(const char *MangledName)
+{
+    return partialDemangle(MangledName, std::strlen(MangledName));
+}
+
+bool MSPartialDemangler::partialDemangle(const char *MangledName,
+    size_t Length)
+{
+    Demangler *D = static_cast<Demangler *>(Context);
+    D->reset();
+    StringView Name(MangledName, Length);
+    SymbolNode *AST = D->parse(Name);
+    RootNode = D->Error ? nullptr : AST;
+    return RootNode == nullptr;
+}
+
+template<typename Fn>
+static char *printPart(char *Buf, size_t *N, Fn Print)
+{
+    OutputBuffer OB(Buf, N);
+    Print(OB);
+    OB += '\0';
+    if (N != nullptr)
+        *N = OB.getCurrentPosition();
+    return OB.getBuffer();
+}
+
+static FunctionSignatureNode *getSignature(const void *RootNode)
+{
+    const Node *N = static_cast<const Node *>(RootNode);
+    if (N == nullptr || N->kind() != NodeKind::FunctionSymbol)
+        return nullptr;
+    return static_cast<const FunctionSymbolNode *>(N)->Signature;
+}
+
+static IdentifierNode *getUnqualifiedName(const void *RootNode)
+{
+    const SymbolNode *S = static_cast<const SymbolNode *>(RootNode);
+    if (S == nullptr || S->Name == nullptr)
+        return nullptr;
+    return S->Name->getUnqualifiedIdentifier();
+}
+
+char *MSPartialDemangler::finishDemangle(char *Buf, size_t *N,
+    MSDemangleFlags Flags) const
+{
+    const SymbolNode *S = static_cast<const SymbolNode *>(RootNode);
+    if (S == nullptr)
+        return nullptr;
+    OutputFlags OF = getOutputFlags(Flags);
+    return printPart(Buf, N, [S, OF](OutputBuffer &OB) { S->output(OB, OF); });
+}
+
+char *MSPartialDemangler::getScope(char *Buf, size_t *N) const
+{
+    const SymbolNode *S = static_cast<const SymbolNode *>(RootNode);
+    if (S == nullptr)
+        return nullptr;
+    return printPart(Buf, N, [S](OutputBuffer &OB) {
+        if (S->Name == nullptr)
+            return;
+        NodeArrayNode *Components = S->Name->Components;
+        for (size_t I = 0; I + 1 < Components->Count; ++I)
+        {
+            if (I != 0)
+                OB << "::";
+            Components->Nodes[I]->output(OB, OF_Default);
+        }
+    });
+}
+
+char *MSPartialDemangler::getBaseName(char *Buf, size_t *N) const
+{
+    if (RootNode == nullptr)
+        return nullptr;
+    IdentifierNode *Id = getUnqualifiedName(RootNode);
+    return printPart(Buf, N, [Id](OutputBuffer &OB) {
+        // Identifiers print their template arguments themselves, and not
+        // always last, so have them leave them out.
+        if (Id != nullptr)
+            Id->output(OB, OF_NoTemplateParameters);
+    });
+}
+
+char *MSPartialDemangler::getTemplateArgs(char *Buf, size_t *N) const
+{
+    if (RootNode == nullptr)
+        return nullptr;
+    IdentifierNode *Id = getUnqualifiedName(RootNode);
+    return printPart(Buf, N, [Id](OutputBuffer &OB) {
+        if (Id != nullptr)
+            Id->outputTemplateParameters(OB, OF_Default);
+    });
+}
+
+char *MSPartialDemangler::getFunctionParameters(char *Buf, size_t *N) const
+{
+    FunctionSignatureNode *Sig = getSignature(RootNode);
+    if (Sig == nullptr)
+        return nullptr;
+    return printPart(Buf, N, [Sig](OutputBuffer &OB) {
+        OB << "(";
+        if (Sig->Params)
+            Sig->Params->output(OB, OF_Default);
+        else if (!(Sig->FunctionClass & FC_NoParameterList))
+            OB << "void";
+        if (Sig->IsVariadic)
+        {
+            if (OB.back() != '(')
+                OB << ", ";
+            OB << "...";
+        }
+        OB << ")";
+    });
+}
+
+char *MSPartialDemangler::getFunctionReturnType(char *Buf, size_t *N) const
+{
+    FunctionSignatureNode *Sig = getSignature(RootNode);
+    if (Sig == nullptr)
+        return nullptr;
+    return printPart(Buf, N, [Sig](OutputBuffer &OB) {
+        if (Sig->ReturnType)
+            Sig->ReturnType->output(OB, OF_Default);
+    });
+}
+
+char *MSPartialDemangler::getCallingConvention(char *Buf, size_t *N) const
+{
+    FunctionSignatureNode *Sig = getSignature(RootNode);
+    if (Sig == nullptr)
+        return nullptr;
+    return printPart(Buf, N, [Sig](OutputBuffer &OB) {
+        outputCallingConvention(OB, Sig->CallConvention);
+        // Some conventions are printed with a space after them.
+        if (!OB.empty() && OB.back() == ' ')
+            OB.setCurrentPosition(OB.getCurrentPosition() - 1);
+    });
+}
+
+MSAccess MSPartialDemangler::getAccess() const
+{
+    const Node *N = static_cast<const Node *>(RootNode);
+    if (N == nullptr)
+        return MSAccess::None;
+    if (FunctionSignatureNode *Sig = getSignature(RootNode))
+    {
+        if (Sig->FunctionClass & FC_Public)
+            return MSAccess::Public;
+        if (Sig->FunctionClass & FC_Protected)
+            return MSAccess::Protected;
+        if (Sig->FunctionClass & FC_Private)
+            return MSAccess::Private;
+        return MSAccess::None;
+    }
+    if (N->kind() != NodeKind::VariableSymbol)
+        return MSAccess::None;
+    switch (static_cast<const VariableSymbolNode *>(N)->SC)
+    {
+        case StorageClass::PublicStatic:
+            return MSAccess::Public;
+        case StorageClass::ProtectedStatic:
+            return MSAccess::Protected;
+        case StorageClass::PrivateStatic:
+            return MSAccess::Private;
+        default:
+            return MSAccess::None;
+    }
+}
+
+MSSymbolKind MSPartialDemangler::getKind() const
+{
+    const SymbolNode *S = static_cast<const SymbolNode *>(RootNode);
+    assert(S != nullptr && "Nothing demangled!");
+    switch (S->SpecialKind)
+    {
+        case SpecialIntrinsicKind::Vftable:
+            return MSSymbolKind::Vftable;
+        case SpecialIntrinsicKind::Vbtable:
+            return MSSymbolKind::Vbtable;
+        case SpecialIntrinsicKind::LocalVftable:
+            return MSSymbolKind::LocalVftable;
+        case SpecialIntrinsicKind::VcallThunk:
+            return MSSymbolKind::VcallThunk;
+        case SpecialIntrinsicKind::LocalStaticGuard:
+        case SpecialIntrinsicKind::LocalStaticThreadGuard:
+            return MSSymbolKind::LocalStaticGuard;
+        case SpecialIntrinsicKind::StringLiteralSymbol:
+            return MSSymbolKind::StringLiteral;
+        case SpecialIntrinsicKind::DynamicInitializer:
+            return MSSymbolKind::DynamicInitializer;
+        case SpecialIntrinsicKind::DynamicAtexitDestructor:
+            return MSSymbolKind::DynamicAtexitDestructor;
+        case SpecialIntrinsicKind::RttiTypeDescriptor:
+            return MSSymbolKind::RttiTypeDescriptor;
+        case SpecialIntrinsicKind::RttiBaseClassDescriptor:
+            return MSSymbolKind::RttiBaseClassDescriptor;
+        case SpecialIntrinsicKind::RttiBaseClassArray:
+            return MSSymbolKind::RttiBaseClassArray;
+        case SpecialIntrinsicKind::RttiClassHierarchyDescriptor:
+            return MSSymbolKind::RttiClassHierarchyDescriptor;
+        case SpecialIntrinsicKind::RttiCompleteObjLocator:
+            return MSSymbolKind::RttiCompleteObjLocator;
+        default:
+            break;
+    }
+    if (S->kind() == NodeKind::Md5Symbol)
+        return MSSymbolKind::Md5;
+    // The kind of a thunk's signature node isn't reliable, it's overwritten
+    // when the parsed signature is copied into it.
+    if (FunctionSignatureNode *Sig = getSignature(RootNode))
+        return Sig->FunctionClass & (FC_StaticThisAdjust | FC_VirtualThisAdjust)
+            ? MSSymbolKind::Thunk
+            : MSSymbolKind::Function;
+    return MSSymbolKind::Variable;
+}
+
+bool MSPartialDemangler::isFunction() const
+{
+    return getSignature(RootNode) != nullptr;
+}
+
+int llvm::microsoftDemangleNoHeap(const char *MangledName, char *Buf,
+    size_t BufSize, void *Scratch, size_t ScratchSize,
+    MSDemangleFlags Flags)
+{
+    return microsoftDemangleNoHeap(MangledName,
+        MangledName != nullptr ? std::strlen(MangledName) : 0, Buf, BufSize,
+        Scratch, ScratchSize, Flags);
+}
+
+int llvm::microsoftDemangleNoHeap(const char *MangledName, size_t Length,
+    char *Buf, size_t BufSize, void *Scratch, size_t ScratchSize,
+    MSDemangleFlags Flags)
+{
+    if (MangledName == nullptr || Buf == nullptr || BufSize == 0)
+        return demangle_invalid_args;
+    *Buf = '\0';
+    if (Scratch == nullptr)
+        return demangle_memory_alloc_failure;
+
+    Demangler D(Scratch, ScratchSize);
+    StringView Name(MangledName, Length);
+    SymbolNode *AST = D.parse(Name);
+    if (D.outOfScratch())
+        return demangle_memory_alloc_failure;
+    if (D.Error)
+        return demangle_invalid_mangled_name;
+
+    // Keep the last byte for the terminator.
+    OutputBuffer OB(Buf, BufSize - 1, /*FixedSize=*/true);
+    AST->output(OB, getOutputFlags(Flags));
+    OB.getBuffer()[OB.getCurrentPosition()] = '\0';
+    return OB.isTruncated() ? demangle_truncated : demangle_success;
+}
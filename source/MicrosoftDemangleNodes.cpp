@@ -80,7 +80,7 @@ static void outputQualifiers(OutputBuffer &OB, Qualifiers Q, bool SpaceBefore,
         OB << " ";
 }
 
-static void outputCallingConvention(OutputBuffer &OB, CallingConv CC)
+void llvm::ms_demangle::outputCallingConvention(OutputBuffer &OB, CallingConv CC)
 {
     outputSpaceIfNecessary(OB);
 
@@ -240,7 +240,7 @@ void TemplateParameterReferenceNode::output(OutputBuffer &OB,
 void IdentifierNode::outputTemplateParameters(OutputBuffer &OB,
     OutputFlags Flags) const
 {
-    if (!TemplateParams)
+    if (!TemplateParams || (Flags & OF_NoTemplateParameters))
         return;
     OB << "<";
     TemplateParams->output(OB, Flags);
@@ -250,6 +250,7 @@ void IdentifierNode::outputTemplateParameters(OutputBuffer &OB,
 void DynamicStructorIdentifierNode::output(OutputBuffer &OB,
     OutputFlags Flags) const
 {
+    Flags = OutputFlags(Flags & ~OF_NoTemplateParameters);
     if (IsDestructor)
         OB << "`dynamic atexit destructor for ";
     else
@@ -395,7 +396,7 @@ void ConversionOperatorIdentifierNode::output(OutputBuffer &OB,
     OB << "operator";
     outputTemplateParameters(OB, Flags);
     OB << " ";
-    TargetType->output(OB, Flags);
+    TargetType->output(OB, OutputFlags(Flags & ~OF_NoTemplateParameters));
 }
 
 void StructorIdentifierNode::output(OutputBuffer &OB, OutputFlags Flags) const
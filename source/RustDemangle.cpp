@@ -78,6 +78,89 @@ namespace
         Yes,
     };
 
+    // What a backref is demangled as. The output of a path also depends on
+    // IsInType and LeaveGenericsOpen, so each combination is its own kind.
+    enum BackrefKind : uint8_t
+    {
+        BK_Path = 0,
+        BK_PathInType = 1 << 0,
+        BK_PathLeaveOpen = 1 << 1,
+        BK_Type = 4,
+        BK_Const = 5,
+    };
+
+    // Where the output of a demangled backref went, so that later references
+    // to the same target can copy it rather than demangle it again.
+    struct BackrefSpan
+    {
+        // Position of the target in the input, plus one; zero if unused.
+        size_t Target = 0;
+        // Lifetimes are printed relative to the ones bound around them.
+        size_t BoundLifetimes;
+        size_t Start;
+        size_t Size;
+        // How much deeper than the backref demangling it recursed.
+        size_t Depth;
+        BackrefKind Kind;
+        // What demanglePath() returned.
+        bool IsOpen;
+    };
+
+    // Part of the demangled name.
+    struct OutputSpan
+    {
+        size_t Start = 0;
+        size_t Size = 0;
+        bool Present = false;
+    };
+
+    struct PathSegment
+    {
+        OutputSpan Span;
+        // The <ns> of a nested path, '\0' for the first segment.
+        char Namespace;
+    };
+
+    // The structure of a symbol's path, for RustPartialDemangler. Spans are
+    // positions in the demangled name; identifiers point into the mangled
+    // one.
+    struct SymbolParts
+    {
+        Identifier Crate = {};
+        bool HasCrate = false;
+        Identifier InstantiatingCrate = {};
+        bool HasInstantiatingCrate = false;
+        OutputSpan ImplSelfType;
+        OutputSpan Trait;
+        OutputSpan GenericArgs;
+        PathSegment *Segments = nullptr;
+        size_t NumSegments = 0;
+        size_t SegmentCapacity = 0;
+
+        void addSegment(size_t Start, size_t End, char Namespace)
+        {
+            if (NumSegments == SegmentCapacity)
+            {
+                SegmentCapacity = SegmentCapacity ? SegmentCapacity * 2 : 8;
+                Segments = static_cast<PathSegment *>(std::realloc(Segments,
+                    SegmentCapacity * sizeof(PathSegment)));
+                if (Segments == nullptr)
+                    std::terminate();
+            }
+            Segments[NumSegments++] = { { Start, End - Start, true }, Namespace };
+        }
+
+        // Forget the last symbol, keeping the memory.
+        void clear()
+        {
+            PathSegment *KeptSegments = Segments;
+            size_t KeptCapacity = SegmentCapacity;
+            *this = SymbolParts();
+            Segments = KeptSegments;
+            SegmentCapacity = KeptCapacity;
+        }
+    };
+
     class Demangler
     {
         // Maximum recursion level. Used to avoid stack overflow.
@@ -94,18 +177,37 @@ namespace
         bool Print;
         // True if an error occurred.
         bool Error;
+        // Deepest RecursionLevel reached, for BackrefSpan::Depth.
+        size_t DeepestLevel;
+        // True when the next demanglePath() call demangles a part of the
+        // symbol's own path that Parts should note.
+        bool InSymbolPath;
+        // True if Output is a caller's fixed-size buffer, which long Punycode
+        // identifiers are decoded in the unused end of.
+        bool FixedOutput = false;
+
+        static constexpr size_t BackrefCacheSize = 64;
+        BackrefSpan BackrefCache[BackrefCacheSize];
 
     public:
         // Demangled output.
         OutputBuffer Output;
+        // If set, demangle() notes the structure of the symbol in it.
+        SymbolParts *Parts = nullptr;
+        // True if a Punycode identifier didn't have room to be decoded in a
+        // fixed-size Output.
+        bool OutOfRoom = false;
 
         Demangler(size_t MaxRecursionLevel = 500);
+        // Demangles into a fixed-size buffer, see rustDemangleNoHeap().
+        Demangler(char *Buf, size_t Size, size_t MaxRecursionLevel = 500);
 
         bool demangle(StringView MangledName);
 
     private:
         bool demanglePath(IsInType Type,
             LeaveGenericsOpen LeaveOpen = LeaveGenericsOpen::No);
+        bool findCrate(size_t PathPosition, Identifier &Crate);
         void demangleImplPath(IsInType InType);
         void demangleGenericArg();
         void demangleType();
@@ -118,22 +220,53 @@ namespace
         void demangleConstBool();
         void demangleConstChar();
 
+        // Demangles the backref's target with Demangler, which returns what
+        // demanglePath() does. Each target is demangled once per kind of use;
+        // later uses copy its output, which keeps nested backrefs from
+        // costing more than what they print.
         template<typename Callable>
-        void demangleBackref(Callable Demangler)
+        bool demangleBackref(BackrefKind Kind, Callable Demangler)
         {
             uint64_t Backref = parseBase62Number();
             if (Error || Backref >= Position)
             {
                 Error = true;
-                return;
+                return false;
             }
 
             if (!Print)
-                return;
+                return false;
+
+            BackrefSpan &Span =
+                BackrefCache[(Backref * 8 + Kind) % BackrefCacheSize];
+            bool Cached = Span.Target == Backref + 1 && Span.Kind == Kind
+                && Span.BoundLifetimes == BoundLifetimes;
+            // Demangling it again would run into the recursion limit, or
+            // wouldn't note the parts of the symbol's path.
+            if (Cached && !InSymbolPath && RecursionLevel + Span.Depth < MaxRecursionLevel
+                && Output.repeat(Span.Start, Span.Size))
+                return Span.IsOpen;
 
             ScopedOverride<size_t> SavePosition(Position, Position);
             Position = Backref;
-            Demangler();
+            size_t SavedDeepest = DeepestLevel;
+            DeepestLevel = RecursionLevel;
+            size_t Start = Output.getCurrentPosition();
+            bool IsOpen = Demangler();
+            size_t Depth = DeepestLevel - RecursionLevel;
+            DeepestLevel = std::max(DeepestLevel, SavedDeepest);
+
+            if (!Error && !Cached && !Output.isTruncated())
+            {
+                Span.Target = Backref + 1;
+                Span.BoundLifetimes = BoundLifetimes;
+                Span.Start = Start;
+                Span.Size = Output.getCurrentPosition() - Start;
+                Span.Depth = Depth;
+                Span.Kind = Kind;
+                Span.IsOpen = IsOpen;
+            }
+            return IsOpen;
         }
 
         Identifier parseIdentifier();
@@ -159,13 +292,33 @@ namespace
 
 } // namespace
 
-char *llvm::rustDemangle(const char *MangledName)
+static bool isLegacySymbol(StringView Mangled);
+static void demangleLegacy(StringView Mangled, OutputBuffer &Output,
+    RustDemangleFlags Flags);
+
+char *llvm::rustDemangle(const char *MangledName, RustDemangleFlags Flags)
 {
     if (MangledName == nullptr)
         return nullptr;
+    return rustDemangle(MangledName, std::strlen(MangledName), Flags);
+}
+
+char *llvm::rustDemangle(const char *MangledName, size_t Length,
+    RustDemangleFlags Flags)
+{
+    if (MangledName == nullptr)
+        return nullptr;
+
+    StringView Mangled(MangledName, Length);
+    if (isLegacySymbol(Mangled))
+    {
+        OutputBuffer Output;
+        demangleLegacy(Mangled, Output, Flags);
+        Output += '\0';
+        return Output.getBuffer();
+    }
 
     // Return early if mangled name doesn't look like a Rust symbol.
-    StringView Mangled(MangledName);
     if (!Mangled.startsWith("_R"))
         return nullptr;
 
@@ -181,9 +334,54 @@ char *llvm::rustDemangle(const char *MangledName)
     return D.Output.getBuffer();
 }
 
+int llvm::rustDemangleNoHeap(const char *MangledName, char *Buf, size_t BufSize,
+    RustDemangleFlags Flags)
+{
+    return rustDemangleNoHeap(MangledName,
+        MangledName != nullptr ? std::strlen(MangledName) : 0, Buf, BufSize,
+        Flags);
+}
+
+int llvm::rustDemangleNoHeap(const char *MangledName, size_t Length,
+    char *Buf, size_t BufSize, RustDemangleFlags Flags)
+{
+    if (MangledName == nullptr || Buf == nullptr || BufSize == 0)
+        return demangle_invalid_args;
+    *Buf = '\0';
+
+    StringView Mangled(MangledName, Length);
+    if (isLegacySymbol(Mangled))
+    {
+        OutputBuffer Output(Buf, BufSize - 1, /*FixedSize=*/true);
+        demangleLegacy(Mangled, Output, Flags);
+        Output.getBuffer()[Output.getCurrentPosition()] = '\0';
+        return Output.isTruncated() ? demangle_truncated : demangle_success;
+    }
+
+    if (!Mangled.startsWith("_R"))
+        return demangle_invalid_mangled_name;
+
+    // Keep the last byte for the terminator.
+    Demangler D(Buf, BufSize - 1);
+    if (!D.demangle(Mangled))
+    {
+        *Buf = '\0';
+        return D.OutOfRoom ? demangle_memory_alloc_failure
+                           : demangle_invalid_mangled_name;
+    }
+
+    D.Output.getBuffer()[D.Output.getCurrentPosition()] = '\0';
+    return D.Output.isTruncated() ? demangle_truncated : demangle_success;
+}
+
 Demangler::Demangler(size_t MaxRecursionLevel) :
     MaxRecursionLevel(MaxRecursionLevel) { }
 
+Demangler::Demangler(char *Buf, size_t Size, size_t MaxRecursionLevel) :
+    MaxRecursionLevel(MaxRecursionLevel),
+    FixedOutput(true),
+    Output(Buf, Size, /*FixedSize=*/true) { }
+
 static inline bool isDigit(const char C)
 {
     return '0' <= C && C <= '9';
@@ -221,7 +419,12 @@ bool Demangler::demangle(StringView Mangled)
     Error = false;
     Print = true;
     RecursionLevel = 0;
+    DeepestLevel = 0;
+    InSymbolPath = Parts != nullptr;
+    OutOfRoom = false;
     BoundLifetimes = 0;
+    for (BackrefSpan &Span : BackrefCache)
+        Span.Target = 0;
 
     if (!Mangled.consumeFront("_R"))
     {
@@ -234,6 +437,7 @@ bool Demangler::demangle(StringView Mangled)
 
     demanglePath(IsInType::No);
 
+    size_t InstantiatingCrate = Position;
     if (Position != Input.size())
     {
         ScopedOverride<bool> SavePrint(Print, false);
@@ -243,6 +447,14 @@ bool Demangler::demangle(StringView Mangled)
     if (Position != Input.size())
         Error = true;
 
+    if (Parts != nullptr && !Error)
+    {
+        Parts->HasCrate = findCrate(0, Parts->Crate);
+        if (InstantiatingCrate != Input.size())
+            Parts->HasInstantiatingCrate =
+                findCrate(InstantiatingCrate, Parts->InstantiatingCrate);
+    }
+
     if (!Suffix.empty())
     {
         print(" (");
@@ -272,46 +484,67 @@ bool Demangler::demangle(StringView Mangled)
 //      | <a-z>    // internal namespaces
 bool Demangler::demanglePath(IsInType InType, LeaveGenericsOpen LeaveOpen)
 {
+    // Only the paths this one passes it on to are part of the symbol's path
+    // too.
+    bool OnSymbolPath = InSymbolPath;
+    InSymbolPath = false;
+
     if (Error || RecursionLevel >= MaxRecursionLevel)
     {
         Error = true;
         return false;
     }
+    DeepestLevel = std::max(DeepestLevel, RecursionLevel);
     ScopedOverride<size_t> SaveRecursionLevel(RecursionLevel, RecursionLevel + 1);
 
     switch (consume())
     {
         case 'C':
         {
+            size_t Start = Output.getCurrentPosition();
             parseOptionalBase62Number('s');
             printIdentifier(parseIdentifier());
+            if (OnSymbolPath)
+                Parts->addSegment(Start, Output.getCurrentPosition(), '\0');
             break;
         }
         case 'M':
         {
             demangleImplPath(InType);
+            size_t Start = Output.getCurrentPosition();
             print("<");
+            size_t TypeStart = Output.getCurrentPosition();
             demangleType();
+            size_t TypeEnd = Output.getCurrentPosition();
             print(">");
+            if (OnSymbolPath)
+            {
+                Parts->ImplSelfType = { TypeStart, TypeEnd - TypeStart, true };
+                Parts->addSegment(Start, Output.getCurrentPosition(), '\0');
+            }
             break;
         }
         case 'X':
-        {
             demangleImplPath(InType);
-            print("<");
-            demangleType();
-            print(" as ");
-            demanglePath(IsInType::Yes);
-            print(">");
-            break;
-        }
+            DEMANGLE_FALLTHROUGH;
         case 'Y':
         {
+            size_t Start = Output.getCurrentPosition();
             print("<");
+            size_t TypeStart = Output.getCurrentPosition();
             demangleType();
+            size_t TypeEnd = Output.getCurrentPosition();
             print(" as ");
+            size_t TraitStart = Output.getCurrentPosition();
             demanglePath(IsInType::Yes);
+            size_t TraitEnd = Output.getCurrentPosition();
             print(">");
+            if (OnSymbolPath)
+            {
+                Parts->ImplSelfType = { TypeStart, TypeEnd - TypeStart, true };
+                Parts->Trait = { TraitStart, TraitEnd - TraitStart, true };
+                Parts->addSegment(Start, Output.getCurrentPosition(), '\0');
+            }
             break;
         }
         case 'N':
@@ -322,11 +555,14 @@ bool Demangler::demanglePath(IsInType InType, LeaveGenericsOpen LeaveOpen)
                 Error = true;
                 break;
             }
+            InSymbolPath = OnSymbolPath;
             demanglePath(InType);
 
             uint64_t Disambiguator = parseOptionalBase62Number('s');
             Identifier Ident = parseIdentifier();
 
+            // Past the "::".
+            size_t Start = Output.getCurrentPosition() + 2;
             if (isUpper(NS))
             {
                 // Special namespaces
@@ -355,14 +591,18 @@ bool Demangler::demanglePath(IsInType InType, LeaveGenericsOpen LeaveOpen)
                     printIdentifier(Ident);
                 }
             }
+            if (OnSymbolPath && Start <= Output.getCurrentPosition())
+                Parts->addSegment(Start, Output.getCurrentPosition(), NS);
             break;
         }
         case 'I':
         {
+            InSymbolPath = OnSymbolPath;
             demanglePath(InType);
             // Omit "::" when in a type, where it is optional.
             if (InType == IsInType::No)
                 print("::");
+            size_t Start = Output.getCurrentPosition();
             print("<");
             for (size_t I = 0; !Error && !consumeIf('E'); ++I)
             {
@@ -374,14 +614,18 @@ bool Demangler::demanglePath(IsInType InType, LeaveGenericsOpen LeaveOpen)
                 return true;
             else
                 print(">");
+            if (OnSymbolPath)
+                Parts->GenericArgs = { Start, Output.getCurrentPosition() - Start, true };
             break;
         }
         case 'B':
         {
-            bool IsOpen = false;
-            demangleBackref([&]
-                { IsOpen = demanglePath(InType, LeaveOpen); });
-            return IsOpen;
+            InSymbolPath = OnSymbolPath;
+            BackrefKind Kind = BackrefKind(
+                (InType == IsInType::Yes ? BK_PathInType : BK_Path)
+                | (LeaveOpen == LeaveGenericsOpen::Yes ? BK_PathLeaveOpen : BK_Path));
+            return demangleBackref(Kind, [&]
+                { return demanglePath(InType, LeaveOpen); });
         }
         default:
             Error = true;
@@ -400,6 +644,86 @@ void Demangler::demangleImplPath(IsInType InType)
     demanglePath(InType);
 }
 
+static bool decodePunycode(StringView Input, OutputBuffer &Output,
+    bool FixedOutput, bool &OutOfRoom);
+
+// Finds the crate root of the path at PathPosition, following backrefs even
+// where demangling with printing off skips them, and leaves Position and
+// Error as they were. Returns false if the path is malformed.
+bool Demangler::findCrate(size_t PathPosition, Identifier &Crate)
+{
+    ScopedOverride<size_t> SavePosition(Position, PathPosition);
+    ScopedOverride<bool> SaveError(Error, false);
+    ScopedOverride<bool> SavePrint(Print, false);
+
+    // Backrefs can form a loop in a malformed path.
+    for (size_t Steps = 0; !Error && Steps < MaxRecursionLevel; ++Steps)
+    {
+        char Kind = consume();
+        switch (Kind)
+        {
+            case 'C':
+            {
+                parseOptionalBase62Number('s');
+                Crate = parseIdentifier();
+                if (Error)
+                    return false;
+                // Paths that aren't printed haven't been decoded yet.
+                if (!Crate.Punycode)
+                    return true;
+                OutputBuffer Decoded;
+                bool NoRoom = false;
+                bool Valid = decodePunycode(Crate.Name, Decoded, false, NoRoom);
+                std::free(Decoded.getBuffer());
+                return Valid;
+            }
+            case 'N':
+                // The parent path comes after the namespace.
+                consume();
+                break;
+            case 'I':
+                break;
+            case 'M':
+            case 'X':
+            case 'Y':
+            {
+                // The self type's crate, if the type is a path. Otherwise a
+                // trait's, whose path comes after the type, or for an inherent
+                // impl, that of the impl path before it, which isn't printed.
+                size_t ImplPath = Position;
+                if (Kind != 'Y')
+                    demangleImplPath(IsInType::No);
+                size_t SelfType = Position;
+                demangleType();
+                if (Error || RecursionLevel >= MaxRecursionLevel)
+                    return false;
+                ScopedOverride<size_t> SaveRecursionLevel(RecursionLevel,
+                    RecursionLevel + 1);
+                if (findCrate(SelfType, Crate))
+                    return true;
+                if (Kind == 'M')
+                {
+                    Position = ImplPath;
+                    parseOptionalBase62Number('s');
+                }
+                break;
+            }
+            case 'B':
+            {
+                size_t Start = Position - 1;
+                uint64_t Backref = parseBase62Number();
+                if (Error || Backref >= Start)
+                    return false;
+                Position = Backref;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
 // <generic-arg> = <lifetime>
 //               | <type>
 //               | "K" <const>
@@ -596,6 +920,7 @@ void Demangler::demangleType()
         Error = true;
         return;
     }
+    DeepestLevel = std::max(DeepestLevel, RecursionLevel);
     ScopedOverride<size_t> SaveRecursionLevel(RecursionLevel, RecursionLevel + 1);
 
     size_t Start = Position;
@@ -675,8 +1000,11 @@ void Demangler::demangleType()
             }
             break;
         case 'B':
-            demangleBackref([&]
-                { demangleType(); });
+            demangleBackref(BK_Type, [&]
+                {
+                    demangleType();
+                    return false;
+                });
             break;
         default:
             Position = Start;
@@ -817,6 +1145,7 @@ void Demangler::demangleConst()
         Error = true;
         return;
     }
+    DeepestLevel = std::max(DeepestLevel, RecursionLevel);
     ScopedOverride<size_t> SaveRecursionLevel(RecursionLevel, RecursionLevel + 1);
 
     char C = consume();
@@ -855,8 +1184,11 @@ void Demangler::demangleConst()
     }
     else if (C == 'B')
     {
-        demangleBackref([&]
-            { demangleConst(); });
+        demangleBackref(BK_Const, [&]
+            {
+                demangleConst();
+                return false;
+            });
     }
     else
     {
@@ -1205,32 +1537,24 @@ static inline bool decodePunycodeDigit(char C, size_t &Value)
     return false;
 }
 
-static void removeNullBytes(OutputBuffer &Output, size_t StartIdx)
-{
-    char *Buffer = Output.getBuffer();
-    char *Start = Buffer + StartIdx;
-    char *End = Buffer + Output.getCurrentPosition();
-    Output.setCurrentPosition(std::remove(Start, End, '\0') - Buffer);
-}
-
-// Encodes code point as UTF-8 and stores results in Output. Returns false if
-// CodePoint is not a valid unicode scalar value.
-static inline bool encodeUTF8(size_t CodePoint, char *Output)
+// Encodes code point as UTF-8 and stores results in Output. Returns the number
+// of bytes stored, or 0 if CodePoint is not a valid unicode scalar value.
+static inline size_t encodeUTF8(size_t CodePoint, char *Output)
 {
     if (0xD800 <= CodePoint && CodePoint <= 0xDFFF)
-        return false;
+        return 0;
 
     if (CodePoint <= 0x7F)
     {
         Output[0] = CodePoint;
-        return true;
+        return 1;
     }
 
     if (CodePoint <= 0x7FF)
     {
         Output[0] = 0xC0 | ((CodePoint >> 6) & 0x3F);
         Output[1] = 0x80 | (CodePoint & 0x3F);
-        return true;
+        return 2;
     }
 
     if (CodePoint <= 0xFFFF)
@@ -1238,7 +1562,7 @@ static inline bool encodeUTF8(size_t CodePoint, char *Output)
         Output[0] = 0xE0 | (CodePoint >> 12);
         Output[1] = 0x80 | ((CodePoint >> 6) & 0x3F);
         Output[2] = 0x80 | (CodePoint & 0x3F);
-        return true;
+        return 3;
     }
 
     if (CodePoint <= 0x10FFFF)
@@ -1247,41 +1571,21 @@ static inline bool encodeUTF8(size_t CodePoint, char *Output)
         Output[1] = 0x80 | ((CodePoint >> 12) & 0x3F);
         Output[2] = 0x80 | ((CodePoint >> 6) & 0x3F);
         Output[3] = 0x80 | (CodePoint & 0x3F);
-        return true;
+        return 4;
     }
 
-    return false;
+    return 0;
 }
 
-// Decodes string encoded using punycode and appends results to Output.
-// Returns true if decoding was successful.
-static bool decodePunycode(StringView Input, OutputBuffer &Output)
+// Runs the punycode decoding loop over the non-basic code points starting at
+// Input[InputIdx], after NumBasic basic ones. Insert(N, I) is called to
+// insert code point N before the I-th one so far, and returns false if N is
+// not a valid unicode scalar value. Returns true if decoding was successful.
+template<typename InsertFn>
+static bool decodePunycodeDeltas(StringView Input, size_t InputIdx,
+    size_t NumBasic, InsertFn Insert)
 {
-    size_t OutputSize = Output.getCurrentPosition();
-    size_t InputIdx = 0;
-
-    // Rust uses an underscore as a delimiter.
-    size_t DelimiterPos = StringView::npos;
-    for (size_t I = 0; I != Input.size(); ++I)
-        if (Input[I] == '_')
-            DelimiterPos = I;
-
-    if (DelimiterPos != StringView::npos)
-    {
-        // Copy basic code points before the last delimiter to the output.
-        for (; InputIdx != DelimiterPos; ++InputIdx)
-        {
-            char C = Input[InputIdx];
-            if (!isValid(C))
-                return false;
-            // Code points are padded with zeros while decoding is in progress.
-            char UTF8[4] = { C };
-            Output += StringView(UTF8, UTF8 + 4);
-        }
-        // Skip over the delimiter.
-        ++InputIdx;
-    }
-
+    size_t NumPoints = NumBasic;
     size_t Base = 36;
     size_t Skew = 38;
     size_t Bias = 72;
@@ -1339,7 +1643,7 @@ static bool decodePunycode(StringView Input, OutputBuffer &Output)
                 return false;
             W *= (Base - T);
         }
-        size_t NumPoints = (Output.getCurrentPosition() - OutputSize) / 4 + 1;
+        NumPoints += 1;
         Bias = Adapt(I - OldI, NumPoints);
 
         if (I / NumPoints > Max - N)
@@ -1347,14 +1651,160 @@ static bool decodePunycode(StringView Input, OutputBuffer &Output)
         N += I / NumPoints;
         I = I % NumPoints;
 
-        // Insert N at position I in the output.
-        char UTF8[4] = {};
-        if (!encodeUTF8(N, UTF8))
+        if (!Insert(N, I))
             return false;
-        Output.insert(OutputSize + I * 4, UTF8, 4);
     }
+    return true;
+}
+
+// Identifiers with at most this many code points are decoded in an array on
+// the stack.
+static constexpr size_t MaxStackCodePoints = 256;
+
+// Works out where each code point of a Punycode identifier ends up, given
+// Points[K] and Indices[K], the K-th code point and the index it was inserted
+// before, the basic ones included as appended in order. Going backwards, each
+// code point takes the Indices[K]-th of the slots not taken by those inserted
+// after it, found in a Fenwick tree of free slots in Tree, which has room for
+// Count + 1 entries. Leaves the code points in order in Tree[0, Count).
+static void placeCodePoints(const uint32_t *Points, uint32_t *Indices,
+    uint32_t *Tree, size_t Count)
+{
+    // Every slot starts out free.
+    for (size_t I = 1; I <= Count; ++I)
+        Tree[I] = static_cast<uint32_t>(I & (0 - I));
+    size_t TopBit = 1;
+    while (TopBit * 2 <= Count)
+        TopBit *= 2;
+
+    for (size_t K = Count; K-- != 0;)
+    {
+        // The slot after Indices[K] free ones.
+        size_t Slot = 0;
+        size_t Left = Indices[K] + 1;
+        for (size_t Bit = TopBit; Bit != 0; Bit /= 2)
+        {
+            if (Slot + Bit <= Count && Tree[Slot + Bit] < Left)
+            {
+                Slot += Bit;
+                Left -= Tree[Slot];
+            }
+        }
+        for (size_t I = Slot + 1; I <= Count; I += I & (0 - I))
+            Tree[I] -= 1;
+        Indices[K] = static_cast<uint32_t>(Slot);
+    }
+
+    for (size_t K = 0; K != Count; ++K)
+        Tree[Indices[K]] = Points[K];
+}
+
+// Decodes string encoded using punycode and appends results to Output.
+// Returns true if decoding was successful. The code points are placed in a
+// work area of three words each: on the stack for short identifiers, and
+// otherwise malloc()ed, or if Output is a caller's fixed-size buffer, the
+// unused end of it. If that is too small, OutOfRoom is set and nothing is
+// printed.
+static bool decodePunycode(StringView Input, OutputBuffer &Output,
+    bool FixedOutput, bool &OutOfRoom)
+{
+    size_t InputIdx = 0;
 
-    removeNullBytes(Output, OutputSize);
+    // Rust uses an underscore as a delimiter.
+    size_t DelimiterPos = StringView::npos;
+    for (size_t I = 0; I != Input.size(); ++I)
+        if (Input[I] == '_')
+            DelimiterPos = I;
+
+    // The basic code points, before the last delimiter.
+    StringView Basic;
+    if (DelimiterPos != StringView::npos)
+    {
+        Basic = Input.substr(0, DelimiterPos);
+        for (char C : Basic)
+            if (!isValid(C))
+                return false;
+        // Skip over the delimiter.
+        InputIdx = DelimiterPos + 1;
+    }
+
+    // Nothing but ASCII.
+    if (InputIdx == Input.size())
+    {
+        Output += Basic;
+        return true;
+    }
+
+    // Check the deltas and count the code points before placing any.
+    size_t Count = Basic.size();
+    char UTF8[4];
+    auto CountPoint = [&](size_t N, size_t)
+    {
+        Count += 1;
+        return encodeUTF8(N, UTF8) != 0;
+    };
+    if (!decodePunycodeDeltas(Input, InputIdx, Count, CountPoint))
+        return false;
+    // Nothing more would be printed anyway.
+    if (Output.isTruncated())
+        return true;
+
+    uint32_t StackWords[3 * MaxStackCodePoints + 1];
+    uint32_t *Words = StackWords;
+    void *Allocated = nullptr;
+    if (Count > MaxStackCodePoints)
+    {
+        if (Count > std::numeric_limits<uint32_t>::max() / 4)
+            return false;
+        size_t Size = (3 * Count + 1) * sizeof(uint32_t);
+        if (FixedOutput)
+        {
+            char *Spare = Output.getBuffer() + Output.getCurrentPosition();
+            size_t SpareSize = Output.getBufferCapacity() - Output.getCurrentPosition();
+            size_t Adjustment = (alignof(uint32_t) -
+                reinterpret_cast<uintptr_t>(Spare) % alignof(uint32_t)) % alignof(uint32_t);
+            if (Adjustment > SpareSize || Size > SpareSize - Adjustment)
+            {
+                OutOfRoom = true;
+                return false;
+            }
+            Words = reinterpret_cast<uint32_t *>(Spare + Adjustment);
+        }
+        else
+        {
+            Allocated = std::malloc(Size);
+            if (Allocated == nullptr)
+                std::terminate();
+            Words = static_cast<uint32_t *>(Allocated);
+        }
+    }
+    uint32_t *Points = Words;
+    uint32_t *Indices = Words + Count;
+    uint32_t *Tree = Words + 2 * Count;
+
+    size_t K = 0;
+    for (char C : Basic)
+    {
+        Points[K] = static_cast<unsigned char>(C);
+        Indices[K] = static_cast<uint32_t>(K);
+        ++K;
+    }
+    auto Record = [&](size_t N, size_t I)
+    {
+        Points[K] = static_cast<uint32_t>(N);
+        Indices[K] = static_cast<uint32_t>(I);
+        ++K;
+        return true;
+    };
+    decodePunycodeDeltas(Input, InputIdx, Basic.size(), Record);
+    placeCodePoints(Points, Indices, Tree, Count);
+
+    // In a fixed-size Output the code points sit after where they're printed,
+    // at least four bytes per code point ahead, so printing one never
+    // overwrites the next.
+    for (size_t I = 0; I != Count && !Output.isTruncated(); ++I)
+        Output += StringView(UTF8, encodeUTF8(Tree[I], UTF8));
+    std::free(Allocated);
     return true;
 }
 
@@ -1365,7 +1815,7 @@ void Demangler::printIdentifier(Identifier Ident)
 
     if (Ident.Punycode)
     {
-        if (!decodePunycode(Ident.Name, Output))
+        if (!decodePunycode(Ident.Name, Output, FixedOutput, OutOfRoom))
             Error = true;
     }
     else
@@ -1429,3 +1879,354 @@ bool Demangler::mulAssign(uint64_t &A, uint64_t B)
     A *= B;
     return true;
 }
+
+// Legacy symbols are Itanium nested names, "_ZN" {<length> <element>} "E",
+// whose last element is a hash, "h" followed by 16 hex digits. Elements
+// escape the characters Itanium names can't have as "$" <code> "$", and "::"
+// as "..".
+static constexpr size_t LegacyHashSize = 17;
+
+static bool isLegacyHash(StringView Element)
+{
+    if (Element.size() != LegacyHashSize || Element[0] != 'h')
+        return false;
+    for (size_t I = 1; I < LegacyHashSize; ++I)
+        if (!isDigit(Element[I]) && !('a' <= Element[I] && Element[I] <= 'f'))
+            return false;
+    return true;
+}
+
+// Reads the next <length> <element> of a legacy symbol from Mangled. Returns
+// false if there's none.
+static bool consumeLegacyElement(StringView &Mangled, StringView &Element)
+{
+    if (Mangled.empty() || !isDigit(Mangled.front()))
+        return false;
+    size_t Length = 0;
+    while (!Mangled.empty() && isDigit(Mangled.front()))
+    {
+        size_t Digit = Mangled.popFront() - '0';
+        if (Length > (std::numeric_limits<size_t>::max() - Digit) / 10)
+            return false;
+        Length = Length * 10 + Digit;
+    }
+    if (Length > Mangled.size())
+        return false;
+    Element = Mangled.substr(0, Length);
+    Mangled = Mangled.dropFront(Length);
+    return true;
+}
+
+// Whether Mangled is a legacy Rust symbol, optionally followed by a suffix
+// starting with '.', such as ".llvm.1234".
+static bool isLegacySymbol(StringView Mangled)
+{
+    if (!Mangled.consumeFront("_ZN"))
+        return false;
+    StringView Element;
+    bool Hash = false;
+    while (consumeLegacyElement(Mangled, Element))
+    {
+        for (char C : Element)
+            if (static_cast<unsigned char>(C) >= 0x80)
+                return false;
+        Hash = isLegacyHash(Element);
+    }
+    return Hash && Mangled.consumeFront('E')
+        && (Mangled.empty() || Mangled.front() == '.');
+}
+
+// Prints the $u<hex>$ escape of a code point. Returns false if it doesn't
+// stand for a printable character.
+static bool printLegacyCodePoint(StringView Digits, OutputBuffer &Output)
+{
+    if (Digits.empty())
+        return false;
+    size_t CodePoint = 0;
+    for (char C : Digits)
+    {
+        size_t Digit = 0;
+        if (isDigit(C))
+            Digit = C - '0';
+        else if ('a' <= C && C <= 'f')
+            Digit = 10 + (C - 'a');
+        else
+            return false;
+        CodePoint = CodePoint * 16 + Digit;
+        if (CodePoint > 0x10FFFF)
+            return false;
+    }
+    // Control characters.
+    if (CodePoint < 0x20 || (0x7F <= CodePoint && CodePoint <= 0x9F))
+        return false;
+    char UTF8[4];
+    size_t Size = encodeUTF8(CodePoint, UTF8);
+    if (Size == 0)
+        return false;
+    Output += StringView(UTF8, Size);
+    return true;
+}
+
+// Prints a legacy element, undoing its escapes. Anything from an escape that
+// isn't understood on is printed as it is.
+static void printLegacyElement(StringView Element, OutputBuffer &Output)
+{
+    if (Element.startsWith("_$"))
+        Element = Element.dropFront();
+
+    while (!Element.empty())
+    {
+        size_t Plain = 0;
+        while (Plain < Element.size() && Element[Plain] != '$'
+            && Element[Plain] != '.')
+            ++Plain;
+        Output += Element.substr(0, Plain);
+        Element = Element.dropFront(Plain);
+        if (Element.empty())
+            break;
+
+        if (Element.consumeFront(".."))
+        {
+            Output += "::";
+            continue;
+        }
+        if (Element.consumeFront('.'))
+        {
+            Output += '.';
+            continue;
+        }
+
+        size_t End = Element.dropFront().find('$');
+        if (End == StringView::npos)
+            break;
+        StringView Escape = Element.substr(1, End);
+        char C = '\0';
+        if (Escape == "SP")
+            C = '@';
+        else if (Escape == "BP")
+            C = '*';
+        else if (Escape == "RF")
+            C = '&';
+        else if (Escape == "LT")
+            C = '<';
+        else if (Escape == "GT")
+            C = '>';
+        else if (Escape == "LP")
+            C = '(';
+        else if (Escape == "RP")
+            C = ')';
+        else if (Escape == "C")
+            C = ',';
+
+        if (C != '\0')
+            Output += C;
+        else if (!Escape.startsWith('u')
+            || !printLegacyCodePoint(Escape.dropFront(), Output))
+            break;
+        Element = Element.dropFront(End + 2);
+    }
+    Output += Element;
+}
+
+// Demangles a symbol isLegacySymbol() accepted into Output.
+static void demangleLegacy(StringView Mangled, OutputBuffer &Output,
+    RustDemangleFlags Flags)
+{
+    Mangled.consumeFront("_ZN");
+    StringView Element;
+    for (bool First = true; consumeLegacyElement(Mangled, Element); First = false)
+    {
+        // The hash is the last element.
+        if ((Flags & RDF_NoHash) && Mangled.startsWith('E'))
+            break;
+        if (!First)
+            Output += "::";
+        printLegacyElement(Element, Output);
+    }
+
+    Mangled.consumeFront('E');
+    if (!Mangled.empty())
+    {
+        Output += " (";
+        Output += Mangled;
+        Output += ")";
+    }
+}
+
+namespace
+{
+    // What RustPartialDemangler keeps about the last symbol.
+    struct PartialContext
+    {
+        char *Demangled = nullptr;
+        size_t DemangledSize = 0;
+        SymbolParts Parts;
+
+        void clear()
+        {
+            std::free(Demangled);
+            Demangled = nullptr;
+            DemangledSize = 0;
+            Parts.clear();
+        }
+
+        ~PartialContext()
+        {
+            std::free(Demangled);
+            std::free(Parts.Segments);
+        }
+    };
+} // namespace
+
+RustPartialDemangler::RustPartialDemangler() :
+    Context(new PartialContext) { }
+
+RustPartialDemangler::~RustPartialDemangler()
+{
+    delete static_cast<PartialContext *>(Context);
+}
+
+RustPartialDemangler::RustPartialDemangler(RustPartialDemangler &&Other) :
+    Context(Other.Context)
+{
+    Other.Context = nullptr;
+}
+
+RustPartialDemangler &
+RustPartialDemangler::operator=(RustPartialDemangler &&Other)
+{
+    std::swap(Context, Other.Context);
+    return *this;
+}
+
+bool RustPartialDemangler::partialDemangle(const char *MangledName)
+{
+    return partialDemangle(MangledName,
+        MangledName != nullptr ? std::strlen(MangledName) : 0);
+}
+
+bool RustPartialDemangler::partialDemangle(const char *MangledName,
+    size_t Length)
+{
+    PartialContext *C = static_cast<PartialContext *>(Context);
+    C->clear();
+    if (MangledName == nullptr)
+        return true;
+
+    StringView Mangled(MangledName, Length);
+    if (!Mangled.startsWith("_R"))
+        return true;
+
+    Demangler D;
+    D.Parts = &C->Parts;
+    if (!D.demangle(Mangled))
+    {
+        std::free(D.Output.getBuffer());
+        C->Parts.clear();
+        return true;
+    }
+
+    C->DemangledSize = D.Output.getCurrentPosition();
+    D.Output += '\0';
+    C->Demangled = D.Output.getBuffer();
+    return false;
+}
+
+template<typename Fn>
+static char *printPart(char *Buf, size_t *N, Fn Print)
+{
+    OutputBuffer OB(Buf, N);
+    Print(OB);
+    OB += '\0';
+    if (N != nullptr)
+        *N = OB.getCurrentPosition();
+    return OB.getBuffer();
+}
+
+static char *printSpan(const PartialContext *C, OutputSpan Span, char *Buf,
+    size_t *N)
+{
+    if (C->Demangled == nullptr || !Span.Present)
+        return nullptr;
+    return printPart(Buf, N, [&](OutputBuffer &OB)
+        { OB += StringView(C->Demangled + Span.Start, Span.Size); });
+}
+
+static char *printCrate(Identifier Crate, char *Buf, size_t *N)
+{
+    return printPart(Buf, N, [&](OutputBuffer &OB)
+        {
+            // findCrate() made sure this succeeds.
+            bool OutOfRoom = false;
+            if (Crate.Punycode)
+                decodePunycode(Crate.Name, OB, false, OutOfRoom);
+            else
+                OB += Crate.Name;
+        });
+}
+
+char *RustPartialDemangler::finishDemangle(char *Buf, size_t *N) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    return printSpan(C, { 0, C->DemangledSize, true }, Buf, N);
+}
+
+char *RustPartialDemangler::getCrateName(char *Buf, size_t *N) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    if (C->Demangled == nullptr || !C->Parts.HasCrate)
+        return nullptr;
+    return printCrate(C->Parts.Crate, Buf, N);
+}
+
+char *RustPartialDemangler::getInstantiatingCrate(char *Buf, size_t *N) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    if (C->Demangled == nullptr || !C->Parts.HasInstantiatingCrate)
+        return nullptr;
+    return printCrate(C->Parts.InstantiatingCrate, Buf, N);
+}
+
+size_t RustPartialDemangler::getNumPathSegments() const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    return C->Demangled == nullptr ? 0 : C->Parts.NumSegments;
+}
+
+char *RustPartialDemangler::getPathSegment(size_t Index, char *Buf,
+    size_t *N) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    if (Index >= getNumPathSegments())
+        return nullptr;
+    return printSpan(C, C->Parts.Segments[Index].Span, Buf, N);
+}
+
+char RustPartialDemangler::getPathSegmentNamespace(size_t Index) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    if (Index >= getNumPathSegments())
+        return '\0';
+    return C->Parts.Segments[Index].Namespace;
+}
+
+char *RustPartialDemangler::getImplSelfType(char *Buf, size_t *N) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    return printSpan(C, C->Parts.ImplSelfType, Buf, N);
+}
+
+char *RustPartialDemangler::getTraitName(char *Buf, size_t *N) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    return printSpan(C, C->Parts.Trait, Buf, N);
+}
+
+char *RustPartialDemangler::getGenericArgs(char *Buf, size_t *N) const
+{
+    const PartialContext *C = static_cast<const PartialContext *>(Context);
+    OutputSpan Args = C->Parts.GenericArgs;
+    // No arguments is an empty span rather than a missing one.
+    Args.Present = true;
+    return printSpan(C, Args, Buf, N);
+}
@@ -0,0 +1,277 @@
+//===- simple_name_diff.cpp -----------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Checks that the Itanium fast path for simple names prints exactly what the
+// parser does. itaniumDemangleNoHeap() with no scratch memory can only succeed
+// through the fast path, since the parser needs scratch for its AST, so every
+// name it demangles that way is compared against ItaniumPartialDemangler,
+// which always parses. The corpus is a list of hand-picked names plus names
+// generated from the grammar the fast path accepts, some of them mutated so
+// that it has to give up part way through.
+//
+//===----------------------------------------------------------------------===//
+
+#include <demangler/Demangle.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    // Names the fast path must accept.
+    const char *const SimpleNames[] = {
+        "_Z1fv",
+        "_Z3fooi",
+        "__Z3fooi",
+        "_ZN2ns3Foo3barEPKci",
+        "_ZNK2ns3Foo3getEv",
+        "_ZNVK1A1fEv",
+        "_ZNKR1A1fEv",
+        "_ZNO1A1fEv",
+        "_ZNSt6vector4sizeEv",
+        "_ZSt9terminatev",
+        "_ZN12_GLOBAL__N_14initEv",
+        "_ZL6helperPv",
+        "_ZN1AL1xE",
+        "_Z1fRKN2ns3FooE",
+        "_Z1fOi",
+        "_Z1fPPKPc",
+        "_Z1fKPi",
+        "_Z1fwbcahstijlmxynofdegz",
+        "_Z1fiz",
+        "_Z3fooi.cold",
+        "_Z3fooi.isra.0",
+        "_ZN1A1xE",
+        "_Z5value",
+        "_Z1f3Bar",
+    };
+
+    // Names the fast path leaves to the parser, which must still print them
+    // as it always did.
+    const char *const OtherNames[] = {
+        "_Z1fIiEvT_",
+        "_ZN1AC1Ev",
+        "_ZN1AD2Ev",
+        "_ZNSt6vectorIiSaIiEE9push_backERKi",
+        "_Z1fS_",
+        "_Z1fN1A1BE1CS0_",
+        "_ZNK1AcviEv",
+        "_ZplRK1AS1_",
+        "_Z1fA10_i",
+        "_Z1fPFivE",
+        "_Z1fM1Ai",
+        "_ZZ1fvE1x",
+        "_Z1fDn",
+        "_Z1fu3foo",
+        "_Z1fRRi",
+        "_Z1fPKKi",
+        "_ZTV1A",
+        "_Z",
+        "_Z0",
+        "_Z3fo",
+        "_ZN1AE",
+        "_ZN3fooE",
+        "_Z1f.",
+        "foo",
+    };
+
+    // A small deterministic generator, so that failures reproduce.
+    class Random
+    {
+        uint64_t State;
+
+    public:
+        explicit Random(uint64_t Seed) :
+            State(Seed) { }
+
+        uint32_t next()
+        {
+            State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(State >> 33);
+        }
+
+        size_t below(size_t N)
+        {
+            return next() % N;
+        }
+
+        bool chance(unsigned Percent)
+        {
+            return below(100) < Percent;
+        }
+
+        char pick(const char *Chars)
+        {
+            return Chars[below(std::strlen(Chars))];
+        }
+    };
+
+    std::string sourceName(Random &R)
+    {
+        std::string Name;
+        if (R.chance(5))
+            Name = "_GLOBAL__N_1";
+        else
+            for (size_t I = 0, N = 1 + R.below(12); I != N; ++I)
+                Name += R.pick("abcxyzQ_09");
+        return (R.chance(5) ? "L" : "") + std::to_string(Name.size()) + Name;
+    }
+
+    std::string nestedName(Random &R)
+    {
+        std::string Name = R.chance(20) ? "St" : "";
+        for (size_t I = 0, N = 1 + R.below(4); I != N; ++I)
+            Name += sourceName(R);
+        return Name + "E";
+    }
+
+    std::string type(Random &R)
+    {
+        std::string Type;
+        if (R.chance(20))
+            Type += R.pick("RO");
+        static const char *const Declarators[] = { "P", "K", "PK", "KP" };
+        static const size_t Counts[] = { 0, 0, 0, 1, 2, 3 };
+        for (size_t I = 0, N = Counts[R.below(6)]; I != N; ++I)
+            Type += Declarators[R.below(4)];
+        size_t Kind = R.below(10);
+        if (Kind < 6)
+            Type += R.pick("vwbcahstijlmxynofdegz");
+        else if (Kind < 8)
+            Type += sourceName(R);
+        else
+            Type += "N" + nestedName(R);
+        return Type;
+    }
+
+    std::string generateName(Random &R)
+    {
+        std::string Name = R.chance(25) ? "__Z" : "_Z";
+        if (R.chance(50))
+        {
+            Name += "N";
+            for (const char *Q = "rVK"; *Q != '\0'; ++Q)
+                if (R.chance(15))
+                    Name += *Q;
+            if (R.chance(40))
+                Name += R.pick("RO");
+            Name += nestedName(R);
+        }
+        else
+        {
+            if (R.chance(20))
+                Name += "St";
+            Name += sourceName(R);
+        }
+
+        size_t Params = R.below(20);
+        if (Params == 1)
+            Name += "v";
+        else if (Params > 2)
+            for (size_t I = 0, N = 1 + R.below(5); I != N; ++I)
+                Name += type(R);
+
+        if (R.chance(15))
+        {
+            static const char *const Suffixes[] = {
+                ".cold", ".isra.0", ".constprop.1.llvm.123", "."
+            };
+            Name += Suffixes[R.below(4)];
+        }
+
+        if (R.chance(30))
+        {
+            const char *Alphabet = "_ZNStLEPKROVrvci0123456789.Sabz";
+            for (size_t I = 0, N = 1 + R.below(3); I != N; ++I)
+            {
+                size_t At = R.below(Name.size() + 1);
+                size_t Op = R.below(10);
+                if (Op < 4)
+                    Name.insert(At, 1, R.pick(Alphabet));
+                else if (At == Name.size())
+                    continue;
+                else if (Op < 7)
+                    Name.erase(At, 1);
+                else
+                    Name[At] = R.pick(Alphabet);
+            }
+        }
+        return Name;
+    }
+
+    struct Checker
+    {
+        llvm::ItaniumPartialDemangler Parser;
+        size_t Checked = 0;
+        size_t Fast = 0;
+        size_t Failures = 0;
+
+        void fail(const std::string &Name, const char *What,
+            const char *Expected, const char *Actual)
+        {
+            if (Failures++ < 20)
+                std::fprintf(stderr, "%s: %s\n  parser: %s\n  other:  %s\n",
+                    What, Name.c_str(), Expected != nullptr ? Expected : "(failed)",
+                    Actual != nullptr ? Actual : "(failed)");
+        }
+
+        // Returns whether the fast path demangled Name.
+        bool check(const std::string &Name)
+        {
+            ++Checked;
+            char *Expected = nullptr;
+            if (!Parser.partialDemangle(Name.data(), Name.size()))
+                Expected = Parser.finishDemangle(nullptr, nullptr);
+
+            char Buf[1024];
+            int Status = llvm::itaniumDemangleNoHeap(Name.data(), Name.size(),
+                Buf, sizeof(Buf), nullptr, 0);
+            bool Accepted = Status == llvm::demangle_success;
+            if (Accepted)
+            {
+                ++Fast;
+                if (Expected == nullptr || std::strcmp(Expected, Buf) != 0)
+                    fail(Name, "mismatch", Expected, Buf);
+            }
+
+            // The heap entry point counts the name before printing it, and
+            // must agree whichever way it went.
+            char *Heap = llvm::itaniumDemangle(Name.data(), Name.size(),
+                nullptr, nullptr, nullptr);
+            if ((Heap == nullptr) != (Expected == nullptr) ||
+                (Heap != nullptr && std::strcmp(Expected, Heap) != 0))
+                fail(Name, "itaniumDemangle mismatch", Expected, Heap);
+
+            std::free(Heap);
+            std::free(Expected);
+            return Accepted;
+        }
+    };
+} // unnamed namespace
+
+int main()
+{
+    Checker C;
+
+    for (const char *Name : SimpleNames)
+        if (!C.check(Name))
+            C.fail(Name, "fast path refused", nullptr, nullptr);
+    for (const char *Name : OtherNames)
+        C.check(Name);
+
+    Random R(1);
+    for (size_t I = 0; I != 100000; ++I)
+        C.check(generateName(R));
+
+    std::printf("%zu names, %zu demangled by the fast path, %zu failures\n",
+        C.Checked, C.Fast, C.Failures);
+    return C.Failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,418 @@
+//===- MSBulkDemangle.cpp -------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements scanning COFF objects, PE images and linker maps for
+// Microsoft mangled names, and demangling them in parallel.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MSBulkDemangle.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace llvm;
+using namespace ms_bulk;
+
+// The class ID in the header of a /bigobj COFF object.
+static const char BigObjMagic[] = {
+    '\xc7', '\xa1', '\xba', '\xd1', '\xee', '\xba', '\xa9', '\x4b',
+    '\xaf', '\x20', '\xfa', '\xf6', '\x6a', '\xa4', '\xdc', '\xb8'
+};
+
+static uint16_t read16(const char *P)
+{
+    const uint8_t *U = reinterpret_cast<const uint8_t *>(P);
+    return uint16_t(U[0] | (U[1] << 8));
+}
+
+static uint32_t read32(const char *P)
+{
+    const uint8_t *U = reinterpret_cast<const uint8_t *>(P);
+    return uint32_t(U[0]) | (uint32_t(U[1]) << 8) | (uint32_t(U[2]) << 16)
+        | (uint32_t(U[3]) << 24);
+}
+
+static uint64_t read64(const char *P)
+{
+    return uint64_t(read32(P)) | (uint64_t(read32(P + 4)) << 32);
+}
+
+static bool isCOFFMachine(uint16_t Machine)
+{
+    switch (Machine)
+    {
+        case 0x14c: // i386
+        case 0x1c0: // ARM
+        case 0x1c4: // ARMNT
+        case 0x8664: // AMD64
+        case 0xa641: // ARM64EC
+        case 0xa64e: // ARM64X
+        case 0xaa64: // ARM64
+            return true;
+        default:
+            return false;
+    }
+}
+
+InputKind ms_bulk::classifyInput(const char *Data, size_t Size)
+{
+    if (Size >= 64 && Data[0] == 'M' && Data[1] == 'Z')
+        return InputKind::PEImage;
+    if (Size >= 56 && read16(Data) == 0 && read16(Data + 2) == 0xffff
+        && std::memcmp(Data + 12, BigObjMagic, sizeof(BigObjMagic)) == 0)
+        return InputKind::BigObjCOFFObject;
+    if (Size >= 20 && isCOFFMachine(read16(Data)))
+        return InputKind::COFFObject;
+    return InputKind::Text;
+}
+
+static void addName(StringView Name, std::vector<StringView> &Names)
+{
+    if (Name.startsWith('?'))
+        Names.push_back(Name);
+}
+
+// Returns the NUL-terminated string at S, which has Avail bytes left, or an
+// empty name if it isn't terminated in time.
+static StringView terminatedName(const char *S, size_t Avail)
+{
+    const void *End = std::memchr(S, '\0', Avail);
+    if (End == nullptr)
+        return StringView();
+    return StringView(S, static_cast<const char *>(End));
+}
+
+static bool scanSymbolTable(const char *Data, size_t Size, size_t SymbolTable,
+    size_t NumSymbols, size_t RecordSize, std::vector<StringView> &Names)
+{
+    if (SymbolTable > Size || NumSymbols > (Size - SymbolTable) / RecordSize)
+        return false;
+
+    // The string table follows the symbols, starting with its size.
+    const char *Strings = Data + SymbolTable + NumSymbols * RecordSize;
+    size_t StringsSize = Data + Size - Strings;
+    if (StringsSize >= 4)
+        StringsSize = std::min<size_t>(StringsSize, read32(Strings));
+    else
+        StringsSize = 0;
+
+    for (size_t I = 0; I < NumSymbols; ++I)
+    {
+        const char *Record = Data + SymbolTable + I * RecordSize;
+        if (read32(Record) == 0)
+        {
+            // A long name, in the string table.
+            size_t Offset = read32(Record + 4);
+            if (Offset >= 4 && Offset < StringsSize)
+                addName(terminatedName(Strings + Offset, StringsSize - Offset),
+                    Names);
+        }
+        else
+        {
+            // A short name, in place and only terminated if under 8 bytes.
+            const void *End = std::memchr(Record, '\0', 8);
+            addName(StringView(Record, End ? static_cast<const char *>(End) : Record + 8),
+                Names);
+        }
+        // Skip the auxiliary records, counted in the last byte.
+        I += static_cast<uint8_t>(Record[RecordSize - 1]);
+    }
+    return true;
+}
+
+bool ms_bulk::scanCOFFObject(const char *Data, size_t Size,
+    std::vector<StringView> &Names)
+{
+    if (classifyInput(Data, Size) == InputKind::BigObjCOFFObject)
+        return scanSymbolTable(Data, Size, read32(Data + 48), read32(Data + 52),
+            20, Names);
+    if (Size < 20)
+        return false;
+    return scanSymbolTable(Data, Size, read32(Data + 8), read32(Data + 12), 18,
+        Names);
+}
+
+namespace
+{
+    // Maps RVAs in a PE image to the file contents.
+    class PEImage
+    {
+        const char *Data;
+        size_t Size;
+        const char *Sections = nullptr;
+        size_t NumSections = 0;
+        const char *Directories = nullptr;
+        size_t NumDirectories = 0;
+
+    public:
+        bool Is64Bit = false;
+
+        PEImage(const char *Data, size_t Size) :
+            Data(Data), Size(Size) { }
+
+        bool init()
+        {
+            size_t Header = read32(Data + 0x3c);
+            if (Header > Size - 24 || std::memcmp(Data + Header, "PE\0\0", 4) != 0)
+                return false;
+            const char *FileHeader = Data + Header + 4;
+            NumSections = read16(FileHeader + 2);
+            size_t OptionalSize = read16(FileHeader + 16);
+            const char *Optional = FileHeader + 20;
+            if (OptionalSize > size_t(Data + Size - Optional) || OptionalSize < 2)
+                return false;
+
+            Is64Bit = read16(Optional) == 0x20b;
+            size_t DirectoriesOffset = Is64Bit ? 112 : 96;
+            if (OptionalSize >= DirectoriesOffset)
+            {
+                NumDirectories = std::min<size_t>(read32(Optional + DirectoriesOffset - 4),
+                    (OptionalSize - DirectoriesOffset) / 8);
+                Directories = Optional + DirectoriesOffset;
+            }
+
+            Sections = Optional + OptionalSize;
+            return NumSections <= size_t(Data + Size - Sections) / 40;
+        }
+
+        // Returns the contents at Rva and how many bytes follow in its section,
+        // or nullptr if it isn't backed by the file.
+        const char *at(uint32_t Rva, size_t &Avail) const
+        {
+            for (size_t I = 0; I < NumSections; ++I)
+            {
+                const char *Section = Sections + I * 40;
+                uint32_t Address = read32(Section + 12);
+                uint32_t RawSize = read32(Section + 16);
+                uint32_t RawOffset = read32(Section + 20);
+                if (Rva < Address || Rva - Address >= RawSize)
+                    continue;
+                if (RawOffset > Size || RawSize > Size - RawOffset)
+                    return nullptr;
+                Avail = RawSize - (Rva - Address);
+                return Data + RawOffset + (Rva - Address);
+            }
+            return nullptr;
+        }
+
+        StringView nameAt(uint32_t Rva) const
+        {
+            size_t Avail = 0;
+            const char *S = at(Rva, Avail);
+            return S ? terminatedName(S, Avail) : StringView();
+        }
+
+        const char *directory(size_t Index, size_t &Avail) const
+        {
+            if (Index >= NumDirectories)
+                return nullptr;
+            uint32_t Rva = read32(Directories + Index * 8);
+            return Rva ? at(Rva, Avail) : nullptr;
+        }
+
+        // Adds the names in an import name table, which is terminated by a
+        // null entry. Entries with the top bit set are imports by ordinal.
+        void scanImportNames(uint32_t Rva, std::vector<StringView> &Names) const
+        {
+            size_t Avail = 0;
+            const char *Table = at(Rva, Avail);
+            size_t EntrySize = Is64Bit ? 8 : 4;
+            for (; Table && Avail >= EntrySize; Table += EntrySize, Avail -= EntrySize)
+            {
+                uint64_t Entry = Is64Bit ? read64(Table) : read32(Table);
+                if (Entry == 0)
+                    break;
+                if (Entry >> (EntrySize * 8 - 1))
+                    continue;
+                // Skip the hint in front of the name.
+                addName(nameAt(uint32_t(Entry) + 2), Names);
+            }
+        }
+    };
+} // unnamed namespace
+
+bool ms_bulk::scanPEImage(const char *Data, size_t Size,
+    std::vector<StringView> &Names)
+{
+    if (Size < 64)
+        return false;
+    PEImage Image(Data, Size);
+    if (!Image.init())
+        return false;
+
+    size_t Avail = 0;
+    if (const char *Exports = Image.directory(0, Avail))
+    {
+        if (Avail < 40)
+            return false;
+        uint32_t NumNames = read32(Exports + 24);
+        size_t TableAvail = 0;
+        const char *Table = Image.at(read32(Exports + 32), TableAvail);
+        if (Table == nullptr && NumNames != 0)
+            return false;
+        NumNames = std::min<size_t>(NumNames, TableAvail / 4);
+        for (uint32_t I = 0; I < NumNames; ++I)
+            addName(Image.nameAt(read32(Table + I * 4)), Names);
+    }
+
+    // Import descriptors are 20 bytes, ending with a null one.
+    const char *Imports = Image.directory(1, Avail);
+    for (; Imports && Avail >= 20; Imports += 20, Avail -= 20)
+    {
+        uint32_t NameTable = read32(Imports);
+        uint32_t AddressTable = read32(Imports + 16);
+        if (NameTable == 0 && AddressTable == 0)
+            break;
+        Image.scanImportNames(NameTable ? NameTable : AddressTable, Names);
+    }
+
+    // Delay-load descriptors are 32 bytes, ending with a null one.
+    const char *DelayImports = Image.directory(13, Avail);
+    for (; DelayImports && Avail >= 32; DelayImports += 32, Avail -= 32)
+    {
+        uint32_t NameTable = read32(DelayImports + 16);
+        if (read32(DelayImports + 4) == 0)
+            break;
+        if (NameTable != 0)
+            Image.scanImportNames(NameTable, Names);
+    }
+    return true;
+}
+
+static bool isSpace(char C)
+{
+    return C == ' ' || C == '\t' || C == '\n' || C == '\r' || C == '\v'
+        || C == '\f' || C == '\0';
+}
+
+// Whether a '?' after C starts a name rather than being part of a word.
+static bool startsWord(char C)
+{
+    return !std::isalnum(static_cast<unsigned char>(C)) && C != '_' && C != '?'
+        && C != '@' && C != '$';
+}
+
+void ms_bulk::scanText(const char *Data, size_t Size,
+    std::vector<StringView> &Names)
+{
+    for (size_t I = 0; I < Size; ++I)
+    {
+        if (Data[I] != '?')
+            continue;
+        bool Imported = I >= 6 && std::memcmp(Data + I - 6, "__imp_", 6) == 0;
+        if (I != 0 && !Imported && !startsWord(Data[I - 1]))
+            continue;
+        size_t End = I;
+        while (End < Size && !isSpace(Data[End]))
+            ++End;
+        Names.push_back(StringView(Data + I, Data + End));
+        I = End;
+    }
+}
+
+bool ms_bulk::scanInput(const char *Data, size_t Size,
+    std::vector<StringView> &Names)
+{
+    switch (classifyInput(Data, Size))
+    {
+        case InputKind::COFFObject:
+        case InputKind::BigObjCOFFObject:
+            return scanCOFFObject(Data, Size, Names);
+        case InputKind::PEImage:
+            return scanPEImage(Data, Size, Names);
+        case InputKind::Text:
+            scanText(Data, Size, Names);
+            return true;
+    }
+    return false;
+}
+
+// Demangles Names[Begin, End) into Table.Symbols, with the demangled names
+// going to Strings. Their offsets are relative to Strings.
+static void demangleRange(const std::vector<StringView> &Names, size_t Begin,
+    size_t End, MSDemangleFlags Flags, SymbolTable &Table,
+    std::string &Strings)
+{
+    MSDemangleContext Context;
+    char *Buf = nullptr;
+    size_t BufSize = 0;
+
+    for (size_t I = Begin; I < End; ++I)
+    {
+        StringView Name = Names[I];
+        Symbol &S = Table.Symbols[I];
+        S.Mangled = Name;
+
+        size_t Read = 0;
+        size_t N = BufSize;
+        char *Demangled = microsoftDemangle(Name.begin(), Name.size(), &Read,
+            Buf, &N, nullptr, Context, Flags);
+        if (Demangled == nullptr)
+            continue;
+        // N is what the name took, the buffer may be bigger.
+        Buf = Demangled;
+        BufSize = std::max(BufSize, N);
+        if (N <= 1)
+            continue;
+
+        S.Mangled = StringView(Name.begin(), Read);
+        S.DemangledOffset = Strings.size();
+        S.DemangledSize = N - 1;
+        Strings.append(Demangled, N);
+    }
+    std::free(Buf);
+}
+
+SymbolTable ms_bulk::demangleAll(const std::vector<StringView> &Names,
+    unsigned Threads, MSDemangleFlags Flags)
+{
+    // Don't bother starting threads for only a few names each.
+    constexpr size_t MinNamesPerThread = 256;
+
+    if (Threads == 0)
+        Threads = std::max(1u, std::thread::hardware_concurrency());
+    Threads = unsigned(std::min<size_t>(Threads,
+        std::max<size_t>(1, Names.size() / MinNamesPerThread)));
+
+    SymbolTable Table;
+    Table.Symbols.resize(Names.size());
+    std::vector<std::string> Strings(Threads);
+    std::vector<std::thread> Workers;
+    size_t PerThread = (Names.size() + Threads - 1) / Threads;
+    for (unsigned T = 1; T < Threads; ++T)
+    {
+        size_t Begin = std::min(Names.size(), T * PerThread);
+        size_t End = std::min(Names.size(), Begin + PerThread);
+        Workers.emplace_back(demangleRange, std::cref(Names), Begin, End, Flags,
+            std::ref(Table), std::ref(Strings[T]));
+    }
+    demangleRange(Names, 0, std::min(Names.size(), PerThread), Flags, Table,
+        Strings[0]);
+    for (std::thread &Worker : Workers)
+        Worker.join();
+
+    // Concatenate what each thread demangled, moving its offsets along.
+    size_t Total = 0;
+    for (const std::string &S : Strings)
+        Total += S.size();
+    Table.Strings.reserve(Total);
+    for (unsigned T = 0; T < Threads; ++T)
+    {
+        size_t Base = Table.Strings.size();
+        size_t Begin = std::min(Names.size(), T * PerThread);
+        size_t End = std::min(Names.size(), Begin + PerThread);
+        for (size_t I = Begin; I < End; ++I)
+            Table.Symbols[I].DemangledOffset += Base;
+        Table.Strings += Strings[T];
+    }
+    return Table;
+}
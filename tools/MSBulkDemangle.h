@@ -0,0 +1,106 @@
+//===--- MSBulkDemangle.h ---------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Pulls Microsoft mangled names out of COFF object files, PE images and MSVC
+// linker .map files, and demangles them in bulk.
+//
+// Unlike the demangler itself this needs a hosted environment (threads), so
+// it's only built with the tools.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DEMANGLE_MSBULKDEMANGLE_H
+#define LLVM_DEMANGLE_MSBULKDEMANGLE_H
+
+#include <demangler/Demangle.h>
+#include <demangler/StringView.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llvm
+{
+    namespace ms_bulk
+    {
+        using itanium_demangle::StringView;
+
+        enum class InputKind
+        {
+            COFFObject,
+            BigObjCOFFObject,
+            PEImage,
+            Text,
+        };
+
+        // Guesses what Data holds from its header. Anything that isn't a COFF
+        // object or a PE image is taken to be text, such as a .map file.
+        InputKind classifyInput(const char *Data, size_t Size);
+
+        // These append the names starting with '?' to Names. The names point
+        // into Data. They return false if Data is malformed, keeping the names
+        // found up to that point.
+
+        // Names in the symbol table of a regular or /bigobj COFF object.
+        bool scanCOFFObject(const char *Data, size_t Size,
+            std::vector<StringView> &Names);
+
+        // Names in the import, delay-load import and export tables of a PE
+        // image.
+        bool scanPEImage(const char *Data, size_t Size,
+            std::vector<StringView> &Names);
+
+        // Whitespace-separated words starting with '?', or with "__imp_?".
+        // Trailing punctuation is left on; demangling drops it.
+        void scanText(const char *Data, size_t Size,
+            std::vector<StringView> &Names);
+
+        // Picks one of the above using classifyInput().
+        bool scanInput(const char *Data, size_t Size,
+            std::vector<StringView> &Names);
+
+        struct Symbol
+        {
+            // The mangled name, without whatever followed it in the input
+            // if it was demangled.
+            StringView Mangled;
+
+            // Where the demangled name is in SymbolTable::Strings. Size is 0
+            // if the name couldn't be demangled.
+            size_t DemangledOffset = 0;
+            size_t DemangledSize = 0;
+
+            bool demangled() const
+            {
+                return DemangledSize != 0;
+            }
+        };
+
+        struct SymbolTable
+        {
+            // One per input name, in the same order.
+            std::vector<Symbol> Symbols;
+
+            // The demangled names, each followed by a NUL.
+            std::string Strings;
+
+            const char *demangled(const Symbol &S) const
+            {
+                return Strings.data() + S.DemangledOffset;
+            }
+        };
+
+        // Demangles Names on Threads threads (0 for one per core). The names
+        // don't have to be NUL-terminated.
+        SymbolTable demangleAll(const std::vector<StringView> &Names,
+            unsigned Threads = 0, MSDemangleFlags Flags = MSDF_None);
+    } // namespace ms_bulk
+} // namespace llvm
+
+#endif // LLVM_DEMANGLE_MSBULKDEMANGLE_H
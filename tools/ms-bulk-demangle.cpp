@@ -0,0 +1,139 @@
+//===- ms-bulk-demangle.cpp -----------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Demangles the Microsoft names in COFF objects, PE images and MSVC linker
+// .map files given on the command line, printing one
+// "<mangled><tab><demangled>" line per name.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MSBulkDemangle.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace ms_bulk;
+
+namespace
+{
+    // A file's contents, mapped.
+    struct InputFile
+    {
+        void *Mapping = nullptr;
+        size_t MappingSize = 0;
+
+        InputFile() = default;
+        InputFile(const InputFile &) = delete;
+        InputFile &operator=(const InputFile &) = delete;
+
+        ~InputFile()
+        {
+            if (Mapping != nullptr)
+                munmap(Mapping, MappingSize);
+        }
+    };
+} // unnamed namespace
+
+static bool openInput(const char *Path, InputFile &File,
+    std::vector<StringView> &Names)
+{
+    int FD = open(Path, O_RDONLY);
+    if (FD < 0)
+        return false;
+    struct stat Stat;
+    if (fstat(FD, &Stat) != 0)
+    {
+        close(FD);
+        return false;
+    }
+    size_t Size = static_cast<size_t>(Stat.st_size);
+    if (Size == 0)
+    {
+        close(FD);
+        return true;
+    }
+    void *Mapping = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, FD, 0);
+    close(FD);
+    if (Mapping == MAP_FAILED)
+        return false;
+    File.Mapping = Mapping;
+    File.MappingSize = Size;
+
+    const char *Data = static_cast<const char *>(Mapping);
+    if (!scanInput(Data, Size, Names))
+        std::fprintf(stderr, "%s: malformed file, some names may be missing\n",
+            Path);
+    return true;
+}
+
+static void usage(const char *Argv0)
+{
+    std::fprintf(stderr,
+        "usage: %s [-j threads] [-a] file...\n"
+        "  -j  number of threads to demangle on (default: one per core)\n"
+        "  -a  also list names that couldn't be demangled\n",
+        Argv0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned Threads = 0;
+    bool ListFailures = false;
+    int I = 1;
+    for (; I < argc && argv[I][0] == '-'; ++I)
+    {
+        if (std::strcmp(argv[I], "-j") == 0 && I + 1 < argc)
+            Threads = static_cast<unsigned>(std::strtoul(argv[++I], nullptr, 10));
+        else if (std::strcmp(argv[I], "-a") == 0)
+            ListFailures = true;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (I == argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int Result = 0;
+    std::vector<InputFile> Files(argc - I);
+    std::vector<StringView> Names;
+    for (int F = I; F < argc; ++F)
+    {
+        if (!openInput(argv[F], Files[F - I], Names))
+        {
+            std::fprintf(stderr, "%s: %s\n", argv[F], std::strerror(errno));
+            Result = 1;
+        }
+    }
+
+    SymbolTable Table = demangleAll(Names, Threads);
+    for (const Symbol &S : Table.Symbols)
+    {
+        if (!S.demangled() && !ListFailures)
+            continue;
+        std::fwrite(S.Mangled.begin(), 1, S.Mangled.size(), stdout);
+        std::fputc('\t', stdout);
+        if (S.demangled())
+            std::fwrite(Table.demangled(S), 1, S.DemangledSize, stdout);
+        std::fputc('\n', stdout);
+    }
+    return Result;
+}
@@ -0,0 +1,97 @@
+//===- output-buffer-bench.cpp --------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Times insertions into an OutputBuffer at growing output sizes: repeated
+// prepend(), single characters inserted at the front, and the insertion
+// pattern of Punycode decoding, where each code point goes in a little after
+// the previous one and the position now and then wraps back to the start.
+// With the gap buffer the time per insertion should stay flat as the output
+// grows; a column that grows with the size means some pattern has gone
+// quadratic again.
+//
+//===----------------------------------------------------------------------===//
+
+#include <demangler/Utility.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using llvm::itanium_demangle::OutputBuffer;
+using llvm::itanium_demangle::StringView;
+
+namespace
+{
+    // Prepends Count short strings.
+    void prependAll(OutputBuffer &OB, size_t Count)
+    {
+        for (size_t I = 0; I != Count; ++I)
+            OB.prepend("ab");
+    }
+
+    // Inserts Count single characters at the front, the way a qualifier or
+    // prefix is put in front of what has been printed.
+    void insertAtFront(OutputBuffer &OB, size_t Count)
+    {
+        for (size_t I = 0; I != Count; ++I)
+            OB.insert(0, "y", 1);
+    }
+
+    // Inserts Count characters the way decodePunycode() does: the position
+    // moves forward by a small delta after each one and wraps around at the
+    // end of the output.
+    void insertLikePunycode(OutputBuffer &OB, size_t Count)
+    {
+        size_t Pos = 0;
+        for (size_t I = 0; I != Count; ++I)
+        {
+            size_t Length = OB.getCurrentPosition();
+            Pos = (Pos + I % 3) % (Length + 1);
+            OB.insert(Pos, "\xce\xbb", 2);
+            Pos += 2;
+        }
+    }
+
+    // Returns the nanoseconds per operation of Fill(OB, Count), the best of a
+    // few runs.
+    template<typename FillFn>
+    double measure(FillFn Fill, size_t Count)
+    {
+        double Best = 0;
+        for (int Run = 0; Run != 3; ++Run)
+        {
+            OutputBuffer OB;
+            auto Start = std::chrono::steady_clock::now();
+            Fill(OB, Count);
+            // Flattens the gap, which a real caller pays for too.
+            StringView Printed = OB;
+            auto End = std::chrono::steady_clock::now();
+            if (Printed.empty())
+                std::abort();
+            std::free(OB.getBuffer());
+
+            double Nanoseconds =
+                std::chrono::duration<double, std::nano>(End - Start).count() /
+                static_cast<double>(Count);
+            if (Run == 0 || Nanoseconds < Best)
+                Best = Nanoseconds;
+        }
+        return Best;
+    }
+} // unnamed namespace
+
+int main()
+{
+    std::printf("%10s %12s %12s %12s   (ns per insertion)\n", "count",
+        "prepend", "insert(0)", "punycode");
+    for (size_t Count = 1024; Count <= (size_t(1) << 20); Count *= 4)
+        std::printf("%10zu %12.1f %12.1f %12.1f\n", Count,
+            measure(prependAll, Count), measure(insertAtFront, Count),
+            measure(insertLikePunycode, Count));
+    return 0;
+}